@@ -0,0 +1,308 @@
+#include <CL/sycl.hpp>
+#ifdef ESIMDVER
+#include <CL/sycl/INTEL/esimd.hpp>
+#endif
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../utils.hpp"
+
+// Bandwidth of the fill kernel of tests 01 to 06 and 11 through every memory
+// access model: each element i is written to position Permute(i) of an array,
+// contiguously, with a stride of a cache line or by the affine map of test 11.
+// -DESIMDVER builds the ESIMD models instead of the others, which also run on
+// CPU devices.
+
+enum class AccessModel {
+  Accessor,
+  DeviceUSM,
+  SharedUSM,
+  ESIMDAccessorScatter,
+  ESIMDScatter,
+  ESIMDAccessorBlockStore,
+  ESIMDBlockStore
+};
+
+static std::string ToString(AccessModel model) {
+  switch (model) {
+  case AccessModel::Accessor:
+    return "accessor";
+  case AccessModel::DeviceUSM:
+    return "device USM";
+  case AccessModel::SharedUSM:
+    return "shared USM";
+  case AccessModel::ESIMDAccessorScatter:
+    return "ESIMD scatter to accessor";
+  case AccessModel::ESIMDScatter:
+    return "ESIMD scatter to USM";
+  case AccessModel::ESIMDAccessorBlockStore:
+    return "ESIMD block_store to accessor";
+  case AccessModel::ESIMDBlockStore:
+    return "ESIMD block_store to USM";
+  }
+  return "";
+}
+
+enum class IndexPattern { Contiguous, Strided, Random };
+
+static std::string ToString(IndexPattern pattern) {
+  switch (pattern) {
+  case IndexPattern::Contiguous:
+    return "contiguous";
+  case IndexPattern::Strided:
+    return "strided";
+  case IndexPattern::Random:
+    return "random";
+  }
+  return "";
+}
+
+// Permutations of 32-bit indices of an array of a power of two size, on
+// scalars and simd vectors. Strided reads the array as a matrix with rows of
+// 16 elements column by column, Random is (i * 3 + 17) of test 11 with a
+// large odd multiplier, so neighbours land far apart.
+template <IndexPattern Pattern, typename U>
+static U _PermuteIndex(U i, cl::sycl::cl_uint size) {
+  if constexpr (Pattern == IndexPattern::Contiguous) {
+    return i;
+  } else if constexpr (Pattern == IndexPattern::Strided) {
+    auto constexpr stride = cl::sycl::cl_uint{16};
+    auto nRows = size / stride;
+    return (i & (nRows - 1)) * stride + i / nRows;
+  } else {
+    return (i * cl::sycl::cl_uint{0x9E3779B1} + 17) & (size - 1);
+  }
+}
+
+template <AccessModel Model, IndexPattern Pattern> class BandwidthKernel;
+
+#ifndef ESIMDVER
+// Element i is written to position _PermuteIndex(i), see _BitonicSortLocal
+// for getData
+template <AccessModel Model, IndexPattern Pattern, typename DataGetter>
+static cl::sycl::event _SubmitFill(cl::sycl::queue &queue, size_t size,
+                                   DataGetter getData) {
+  using namespace cl::sycl;
+  return queue.submit([&](handler &h) {
+    auto data = getData(h);
+    auto n = static_cast<cl_uint>(size);
+    h.parallel_for<BandwidthKernel<Model, Pattern>>(
+        range<1>{size}, [=](id<1> id) {
+          auto i = static_cast<cl_uint>(id[0]);
+          data[_PermuteIndex<Pattern>(i, n)] = static_cast<cl_int>(i);
+        });
+  });
+}
+#else
+// Every work item writes SIMDSize elements, accessor scatters and block stores
+// take element offsets like tests 03 and 05, USM scatters byte offsets like
+// test 06
+template <AccessModel Model, IndexPattern Pattern, typename DataGetter>
+static cl::sycl::event _SubmitFillESIMD(cl::sycl::queue &queue, size_t size,
+                                        DataGetter getData) {
+  using namespace cl::sycl;
+  using namespace sycl::INTEL::gpu;
+  auto constexpr SIMDSize = unsigned{16};
+  auto constexpr isBlockStore = Model == AccessModel::ESIMDAccessorBlockStore ||
+                                Model == AccessModel::ESIMDBlockStore;
+  static_assert(!isBlockStore || Pattern == IndexPattern::Contiguous);
+  return queue.submit([&](handler &h) {
+    auto data = getData(h);
+    auto n = static_cast<cl_uint>(size);
+    h.parallel_for<BandwidthKernel<Model, Pattern>>(
+        range<1>{size / SIMDSize}, [=](id<1> id) SYCL_ESIMD_KERNEL {
+          auto ids = simd<unsigned, SIMDSize>(id[0] * SIMDSize, 1);
+          auto values = simd<int, SIMDSize>(ids);
+          if constexpr (Model == AccessModel::ESIMDAccessorBlockStore) {
+            block_store<int, SIMDSize>(data, id[0] * SIMDSize, values);
+          } else if constexpr (Model == AccessModel::ESIMDBlockStore) {
+            block_store<int, SIMDSize>(data + id[0] * SIMDSize, values);
+          } else {
+            auto inds = _PermuteIndex<Pattern>(ids, n);
+            if constexpr (Model == AccessModel::ESIMDAccessorScatter)
+              scatter<int, SIMDSize>(data, values, inds);
+            else
+              scatter<int, SIMDSize>(data, values, inds * sizeof(int));
+          }
+        });
+  });
+}
+#endif
+
+// Runs submit untimed options.nWarmups times and timed options.nRepeats
+// times, and reports its median device time and bandwidth of writes
+template <typename Submit>
+static void MeasureBandwidth(BenchmarkOptions const &options,
+                             std::string_view description, size_t size,
+                             Submit &&submit) {
+  using namespace cl::sycl;
+  using std::chrono::nanoseconds;
+  for (auto i = size_t{0}; i != options.nWarmups; ++i)
+    submit().wait();
+  auto times = std::vector<nanoseconds>();
+  for (auto i = size_t{0}; i != options.nRepeats; ++i) {
+    auto e = event{submit()};
+    e.wait();
+    auto start = e.get_profiling_info<info::event_profiling::command_start>();
+    auto end = e.get_profiling_info<info::event_profiling::command_end>();
+    times.push_back(nanoseconds{end - start});
+  }
+  auto stats = GetStats(times, size);
+  _ReportStats(options, description, size, stats);
+  auto seconds = std::chrono::duration<double>(stats.median).count();
+  std::cout << description << ": "
+            << (seconds == 0 ? 0 : size * sizeof(cl_int) / seconds / 1e9)
+            << " GB/s" << std::endl;
+}
+
+template <IndexPattern Pattern>
+static void CheckFill(cl::sycl::cl_int const *data, size_t size,
+                      std::string_view description) {
+  using namespace cl::sycl;
+  auto n = static_cast<cl_uint>(size);
+  for (auto i = cl_uint{0}; i != n; ++i) {
+    auto pos = _PermuteIndex<Pattern>(i, n);
+    if (data[pos] != static_cast<cl_int>(i)) {
+      auto message = std::stringstream{};
+      message << std::endl
+              << "Result of \"" << description << "\" is wrong at pos " << pos
+              << std::endl;
+      throw std::runtime_error{message.str()};
+    }
+  }
+}
+
+// All access models on arrays of size ints, a power of two
+template <IndexPattern Pattern>
+static void BenchmarkPattern(cl::sycl::queue &queue,
+                             BenchmarkOptions const &options, size_t size) {
+  using namespace cl::sycl;
+  auto patternOptions = options;
+  patternOptions.pattern = ToString(Pattern);
+  auto Description = [](AccessModel model) {
+    return ToString(model) + " " + ToString(Pattern);
+  };
+  auto vec = std::vector<cl_int>(size);
+  auto *device = malloc_device<cl_int>(size, queue);
+
+#ifndef ESIMDVER
+  {
+    auto buf = buffer{vec};
+    MeasureBandwidth(patternOptions, Description(AccessModel::Accessor), size,
+                     [&]() {
+                       return _SubmitFill<AccessModel::Accessor, Pattern>(
+                           queue, size, [&buf](handler &h) {
+                             return buf.template get_access<
+                                 access::mode::discard_write>(h);
+                           });
+                     });
+  }
+  CheckFill<Pattern>(vec.data(), size, Description(AccessModel::Accessor));
+
+  MeasureBandwidth(patternOptions, Description(AccessModel::DeviceUSM), size,
+                   [&]() {
+                     return _SubmitFill<AccessModel::DeviceUSM, Pattern>(
+                         queue, size, [device](handler &) { return device; });
+                   });
+  queue.memcpy(vec.data(), device, size * sizeof(cl_int)).wait();
+  CheckFill<Pattern>(vec.data(), size, Description(AccessModel::DeviceUSM));
+
+  auto *shared = malloc_shared<cl_int>(size, queue);
+  MeasureBandwidth(patternOptions, Description(AccessModel::SharedUSM), size,
+                   [&]() {
+                     return _SubmitFill<AccessModel::SharedUSM, Pattern>(
+                         queue, size, [shared](handler &) { return shared; });
+                   });
+  CheckFill<Pattern>(shared, size, Description(AccessModel::SharedUSM));
+  free(shared, queue);
+#else
+  {
+    auto buf = buffer{vec};
+    MeasureBandwidth(
+        patternOptions, Description(AccessModel::ESIMDAccessorScatter), size,
+        [&]() {
+          return _SubmitFillESIMD<AccessModel::ESIMDAccessorScatter, Pattern>(
+              queue, size, [&buf](handler &h) {
+                return buf.template get_access<access::mode::discard_write>(
+                    h);
+              });
+        });
+  }
+  CheckFill<Pattern>(vec.data(), size,
+                     Description(AccessModel::ESIMDAccessorScatter));
+
+  // Byte offsets are 32-bit
+  if (size * sizeof(cl_int) <= (size_t{1} << 32)) {
+    MeasureBandwidth(patternOptions, Description(AccessModel::ESIMDScatter),
+                     size, [&]() {
+                       return _SubmitFillESIMD<AccessModel::ESIMDScatter,
+                                               Pattern>(
+                           queue, size, [device](handler &) { return device; });
+                     });
+    queue.memcpy(vec.data(), device, size * sizeof(cl_int)).wait();
+    CheckFill<Pattern>(vec.data(), size,
+                       Description(AccessModel::ESIMDScatter));
+  }
+
+  if constexpr (Pattern == IndexPattern::Contiguous) {
+    {
+      auto buf = buffer{vec};
+      MeasureBandwidth(
+          patternOptions, Description(AccessModel::ESIMDAccessorBlockStore),
+          size, [&]() {
+            return _SubmitFillESIMD<AccessModel::ESIMDAccessorBlockStore,
+                                    Pattern>(queue, size, [&buf](handler &h) {
+              return buf.template get_access<access::mode::discard_write>(h);
+            });
+          });
+    }
+    CheckFill<Pattern>(vec.data(), size,
+                       Description(AccessModel::ESIMDAccessorBlockStore));
+
+    MeasureBandwidth(patternOptions, Description(AccessModel::ESIMDBlockStore),
+                     size, [&]() {
+                       return _SubmitFillESIMD<AccessModel::ESIMDBlockStore,
+                                               Pattern>(
+                           queue, size, [device](handler &) { return device; });
+                     });
+    queue.memcpy(vec.data(), device, size * sizeof(cl_int)).wait();
+    CheckFill<Pattern>(vec.data(), size,
+                       Description(AccessModel::ESIMDBlockStore));
+  }
+#endif
+
+  free(device, queue);
+}
+
+// Arrays from 2^pow to 2^maxPow ints are filled in a single run:
+// ./bandwidth pow [maxPow] [--warmups=N] [--repeats=N] [--csv=path]
+// [--json=path], 2^20 ints by default
+// --device=cpu|gpu|host|accelerator|all|<name> selects devices, see GetDevices
+int main(int argc, char *argv[]) {
+  using namespace cl::sycl;
+  auto pow = GetIntArgument(argc, argv, 20);
+  auto maxPow = GetIntArgument(argc, argv, pow, 1);
+  auto options = GetBenchmarkOptions(argc, argv);
+  // Rows of the strided pattern, 32-bit indices
+  if (pow < 4 || maxPow > 31)
+    throw std::runtime_error{"Sizes must be from 2^4 to 2^31"};
+
+  for (auto const &device : GetDevices(argc, argv)) {
+    auto queue = cl::sycl::queue{device, property::queue::enable_profiling{}};
+    options.device = device.get_info<info::device::name>();
+    PrintInfo(queue, std::cout);
+
+    for (auto currentPow = pow; currentPow <= maxPow; ++currentPow) {
+      auto size = size_t{1} << currentPow;
+      std::cout << "Fill of " << size << " ints, "
+                << (size * sizeof(cl_int) >> 20) << " MiB" << std::endl;
+      BenchmarkPattern<IndexPattern::Contiguous>(queue, options, size);
+      BenchmarkPattern<IndexPattern::Strided>(queue, options, size);
+      BenchmarkPattern<IndexPattern::Random>(queue, options, size);
+      std::cout << std::endl;
+    }
+  }
+}
@@ -0,0 +1,150 @@
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../utils.hpp"
+
+// Benchmark of private arrays of work items, generalizing tests 07, 10, 14
+// and 15: every work item fills an array of N elements and reads it back
+// sequentially, where unrolled loops can keep it in registers, or by a
+// dependent chase through it, whose dynamic indices need addressable memory.
+// Time per access grows once the array spills out of the register file.
+
+enum class AccessPattern { Sequential, Chase };
+
+static std::string ToString(AccessPattern pattern) {
+  return pattern == AccessPattern::Sequential ? "sequential" : "chase";
+}
+
+template <typename T, size_t N, AccessPattern Pattern>
+class PrivateMemoryKernel;
+
+// Every work item does about this number of accesses whatever N is
+auto constexpr nAccessesPerWorkItem = size_t{1} << 16;
+
+template <typename T, size_t N, AccessPattern Pattern>
+static cl::sycl::event SubmitPrivateMemory(cl::sycl::queue &queue,
+                                           T *results, size_t nWorkItems) {
+  using namespace cl::sycl;
+  auto constexpr nRounds = std::max<size_t>(1, nAccessesPerWorkItem / N);
+  return queue.submit([&](handler &h) {
+    h.parallel_for<PrivateMemoryKernel<T, N, Pattern>>(
+        range<1>{nWorkItems}, [=](id<1> id) {
+          T x[N];
+          // Odd steps make the chase a single cycle through the array
+          auto step = (2 * id[0] + 1) % N;
+          for (auto i = size_t{0}; i != N; ++i)
+            x[i] = static_cast<T>((i + step) % N);
+          auto result = T{0};
+          for (auto round = size_t{0}; round != nRounds; ++round)
+            if constexpr (Pattern == AccessPattern::Sequential) {
+              // Indices stay static, but every read is mixed with the result
+              // of the previous ones, so rounds cannot be folded into one
+              for (auto i = size_t{0}; i != N; ++i)
+                result += x[i] ^ result;
+            } else {
+              for (auto i = size_t{0}; i != N; ++i)
+                result = x[result];
+            }
+          results[id[0]] = result;
+        });
+  });
+}
+
+// Median device time of the kernel per access of a work item, in nanoseconds
+// of all work items running concurrently
+template <typename T, size_t N, AccessPattern Pattern>
+static void BenchmarkPrivateMemory(cl::sycl::queue &queue,
+                                   BenchmarkOptions const &options,
+                                   std::string_view typeName,
+                                   size_t nWorkItems) {
+  using namespace cl::sycl;
+  using std::chrono::nanoseconds;
+  auto constexpr nRounds = std::max<size_t>(1, nAccessesPerWorkItem / N);
+  auto *results = malloc_device<T>(nWorkItems, queue);
+  for (auto i = size_t{0}; i != options.nWarmups; ++i)
+    SubmitPrivateMemory<T, N, Pattern>(queue, results, nWorkItems).wait();
+  auto times = std::vector<nanoseconds>();
+  for (auto i = size_t{0}; i != options.nRepeats; ++i) {
+    auto e =
+        event{SubmitPrivateMemory<T, N, Pattern>(queue, results, nWorkItems)};
+    e.wait();
+    auto start = e.get_profiling_info<info::event_profiling::command_start>();
+    auto end = e.get_profiling_info<info::event_profiling::command_end>();
+    times.push_back(nanoseconds{end - start});
+  }
+  free(results, queue);
+
+  auto nAccesses = nRounds * N;
+  auto description = std::string{typeName} + " " + ToString(Pattern) +
+                     ", private array of " + std::to_string(N);
+  auto stats = GetStats(times, nWorkItems * nAccesses);
+  auto patternOptions = options;
+  patternOptions.pattern = ToString(Pattern);
+  _ReportStats(patternOptions, description, nWorkItems * nAccesses, stats);
+  std::cout << description << ": "
+            << static_cast<double>(stats.median.count()) / nAccesses
+            << " ns per access" << std::endl;
+}
+
+// Array sizes from 2^3 to 2^14 elements, chosen at compile time so that
+// private arrays have constant size
+template <typename T, AccessPattern Pattern, size_t... Pows>
+static void SweepPrivateMemory(cl::sycl::queue &queue,
+                               BenchmarkOptions const &options,
+                               std::string_view typeName, size_t nWorkItems,
+                               std::index_sequence<Pows...>) {
+  (BenchmarkPrivateMemory<T, size_t{8} << Pows, Pattern>(queue, options,
+                                                          typeName, nWorkItems),
+   ...);
+}
+
+template <typename T>
+static void SweepPrivateMemory(cl::sycl::queue &queue,
+                               BenchmarkOptions const &options,
+                               std::string_view typeName, size_t nWorkItems) {
+  for (auto pattern : {AccessPattern::Sequential, AccessPattern::Chase}) {
+    std::cout << typeName << " " << ToString(pattern) << std::endl;
+    auto pows = std::make_index_sequence<12>{};
+    if (pattern == AccessPattern::Sequential)
+      SweepPrivateMemory<T, AccessPattern::Sequential>(queue, options,
+                                                       typeName, nWorkItems,
+                                                       pows);
+    else
+      SweepPrivateMemory<T, AccessPattern::Chase>(queue, options, typeName,
+                                                  nWorkItems, pows);
+    std::cout << std::endl;
+  }
+}
+
+// ./private_memory [pow] [--warmups=N] [--repeats=N] [--csv=path]
+// [--json=path] runs 2^pow work items, 2^16 by default
+// --type=ushort|uint|ulong|all selects the element type, all by default
+int main(int argc, char *argv[]) {
+  using namespace cl::sycl;
+  auto pow = GetIntArgument(argc, argv, 16);
+  auto nWorkItems = size_t{1} << pow;
+  auto options = GetBenchmarkOptions(argc, argv);
+  auto type = GetOption(argc, argv, "type", "all");
+  if (type != "ushort" && type != "uint" && type != "ulong" && type != "all")
+    throw std::runtime_error{"Unknown type \"" + type + "\""};
+
+  for (auto const &device : GetDevices(argc, argv)) {
+    auto queue = cl::sycl::queue{device, property::queue::enable_profiling{}};
+    options.device = device.get_info<info::device::name>();
+    PrintInfo(queue, std::cout);
+    std::cout << nWorkItems << " work items, " << nAccessesPerWorkItem
+              << " accesses per work item" << std::endl
+              << std::endl;
+    if (type == "ushort" || type == "all")
+      SweepPrivateMemory<cl_ushort>(queue, options, "ushort", nWorkItems);
+    if (type == "uint" || type == "all")
+      SweepPrivateMemory<cl_uint>(queue, options, "uint", nWorkItems);
+    if (type == "ulong" || type == "all")
+      SweepPrivateMemory<cl_ulong>(queue, options, "ulong", nWorkItems);
+  }
+}
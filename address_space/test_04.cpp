@@ -1,14 +1,15 @@
 #include <CL/sycl.hpp>
 #include <CL/sycl/INTEL/esimd.hpp>
 
-int main() {
+#include "../utils.hpp"
+
+int main(int argc, char *argv[]) {
   using namespace cl::sycl;
   using namespace sycl::INTEL::gpu;
   auto size = size_t{16};
   auto constexpr SIMDSize = unsigned{16};
 
-  auto GPUSelector = gpu_selector{};
-  auto q = queue{GPUSelector};
+  auto q = queue{GetDevice(argc, argv)};
   auto *shared = malloc_shared<int>(size, q);
 
   q.submit([&](handler &h) {
@@ -5,6 +5,8 @@
 #include <CL/sycl.hpp>
 #include <CL/sycl/INTEL/esimd.hpp>
 
+#include "../utils.hpp"
+
 template <typename T> void Test(cl::sycl::queue &queue, std::vector<T> &vec) {
   using namespace cl::sycl;
   using namespace sycl::INTEL::gpu;
@@ -28,13 +30,12 @@ template <typename T> void Test(cl::sycl::queue &queue, std::vector<T> &vec) {
   free(sharedData, queue);
 }
 
-int main() {
+int main(int argc, char *argv[]) {
   auto size = 16;
   auto vec = std::vector<int>(size);
   std::iota(vec.begin(), vec.end(), 0);
 
-  auto GPUSelector = cl::sycl::gpu_selector{};
-  auto queue = cl::sycl::queue{GPUSelector};
+  auto queue = cl::sycl::queue{GetDevice(argc, argv)};
 
   Test(queue, vec);
 
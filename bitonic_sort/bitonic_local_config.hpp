@@ -0,0 +1,148 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "../utils.hpp"
+
+// Work group size and number of elements per work item of the local phase
+// Work group sorts WGSize * nElementsPerWorkItem elements in local memory, so
+// the number of large steps done in the local phase is log2 of it.
+struct BitonicLocalConfig {
+  size_t WGSize;
+  size_t nElementsPerWorkItem;
+};
+
+// Local memory is split evenly between the work items of the largest work
+// group. CPU devices execute a work group by a single thread and emulate local
+// memory with ordinary memory of the same small size, so their work groups are
+// limited to keep several elements per work item.
+static BitonicLocalConfig
+GetDefaultBitonicLocalConfig(cl::sycl::device const &device,
+                             size_t elementSize) {
+  using namespace cl::sycl;
+  auto constexpr maxCPUWGSize = size_t{64};
+  // Devices reporting huge local memory would get a few huge work groups
+  auto constexpr maxElementsPerWorkItem = size_t{64};
+  // Reserve for other variables
+  auto constexpr nReservedElements = size_t{16};
+  auto WGSize = size_t{
+      ClosestPowerOf2(device.get_info<info::device::max_work_group_size>())};
+  if (!device.is_gpu() && !device.is_accelerator())
+    WGSize = std::min(WGSize, maxCPUWGSize);
+  auto localMem = device.get_info<info::device::local_mem_size>();
+  while (WGSize > 1 && localMem / WGSize / elementSize < nReservedElements + 2)
+    WGSize /= 2;
+  auto nElementsPerWorkItem = size_t{ClosestPowerOf2(std::min<cl_ulong>(
+      localMem / WGSize / elementSize - nReservedElements,
+      maxElementsPerWorkItem))};
+  assert(nElementsPerWorkItem >= 2);
+  return {WGSize, nElementsPerWorkItem};
+}
+
+// Tuned configurations, a line per device and element size:
+// device name, driver version, element size, WGSize, nElementsPerWorkItem
+// separated by tabs
+using BitonicTuningCache = std::map<std::string, BitonicLocalConfig>;
+
+// SYCL_EXPERIMENTS_TUNING_CACHE or a file in the working directory
+static std::string GetBitonicTuningCachePath() {
+  if (auto *path = std::getenv("SYCL_EXPERIMENTS_TUNING_CACHE"))
+    return path;
+  return "bitonic_tuning.cache";
+}
+
+static std::string _BitonicTuningKey(cl::sycl::device const &device,
+                                     size_t elementSize) {
+  using namespace cl::sycl;
+  return device.get_info<info::device::name>() + "\t" +
+         device.get_info<info::device::driver_version>() + "\t" +
+         std::to_string(elementSize);
+}
+
+// Whole field as a positive number, 0 if it is empty, has other characters or
+// overflows
+static size_t _ParseTuningField(std::string_view field) {
+  auto value = size_t{0};
+  auto [end, error] =
+      std::from_chars(field.data(), field.data() + field.size(), value);
+  if (error != std::errc{} || end != field.data() + field.size())
+    return 0;
+  return value;
+}
+
+// Truncated or hand-edited lines are skipped with a single warning, so a
+// damaged file costs only its damaged entries
+static BitonicTuningCache LoadBitonicTuningCache(std::string const &path) {
+  auto cache = BitonicTuningCache{};
+  auto file = std::ifstream{path};
+  auto line = std::string{};
+  auto nMalformed = size_t{0};
+  while (std::getline(file, line)) {
+    if (line.empty())
+      continue;
+    // The key is everything before the last two fields
+    auto nElementsPos = line.rfind('\t');
+    auto WGSizePos = nElementsPos == std::string::npos || nElementsPos == 0
+                         ? std::string::npos
+                         : line.rfind('\t', nElementsPos - 1);
+    auto config = BitonicLocalConfig{};
+    if (WGSizePos != std::string::npos && WGSizePos != 0) {
+      auto fields = std::string_view{line};
+      config = {_ParseTuningField(fields.substr(
+                    WGSizePos + 1, nElementsPos - WGSizePos - 1)),
+                _ParseTuningField(fields.substr(nElementsPos + 1))};
+    }
+    if (config.WGSize == 0 || config.nElementsPerWorkItem == 0) {
+      ++nMalformed;
+      continue;
+    }
+    cache[line.substr(0, WGSizePos)] = config;
+  }
+  if (nMalformed != 0)
+    std::cerr << "Skipped " << nMalformed << " malformed lines of " << path
+              << std::endl;
+  return cache;
+}
+
+static void SaveBitonicTuningCache(BitonicTuningCache const &cache,
+                                   std::string const &path) {
+  auto file = std::ofstream{path};
+  for (auto const &[key, config] : cache)
+    file << key << "\t" << config.WGSize << "\t"
+         << config.nElementsPerWorkItem << std::endl;
+}
+
+// Loaded once per process, TuneBitonicSortLocal updates it
+static BitonicTuningCache &_BitonicTuningCache() {
+  static auto cache = LoadBitonicTuningCache(GetBitonicTuningCachePath());
+  return cache;
+}
+
+// Tuned configuration if the device and element size are in the cache and the
+// configuration still fits the device, the default one otherwise
+static BitonicLocalConfig GetBitonicLocalConfig(cl::sycl::device const &device,
+                                                size_t elementSize) {
+  using namespace cl::sycl;
+  auto &cache = _BitonicTuningCache();
+  auto found = cache.find(_BitonicTuningKey(device, elementSize));
+  if (found != cache.end()) {
+    auto config = found->second;
+    auto WGElements = config.WGSize * config.nElementsPerWorkItem;
+    if (config.nElementsPerWorkItem >= 2 &&
+        config.WGSize <= device.get_info<info::device::max_work_group_size>() &&
+        WGElements * elementSize <=
+            device.get_info<info::device::local_mem_size>())
+      return config;
+  }
+  return GetDefaultBitonicLocalConfig(device, elementSize);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../utils.hpp"
+
+enum class BitonicPhase { Transfer, Local, Global };
+
+// Commands submitted by a sort, their events are queried for the device time
+// when the queue is created with property::queue::enable_profiling
+struct BitonicProfile {
+  struct Command {
+    BitonicPhase phase;
+    // Large step i and small steps j done by the command
+    std::string step;
+    cl::sycl::event event;
+  };
+  std::vector<Command> commands;
+};
+
+// Does nothing when profile is null, so the sorts record unconditionally
+static void _Record(BitonicProfile *profile, BitonicPhase phase,
+                    cl::sycl::event const &event, std::string step) {
+  if (profile)
+    profile->commands.push_back({phase, std::move(step), event});
+}
+
+static void _Record(BitonicProfile *profile, BitonicPhase phase,
+                    cl::sycl::event const &event, int i, int firstJ,
+                    int lastJ) {
+  if (!profile)
+    return;
+  auto step = "i=" + std::to_string(i) + " j=" + std::to_string(firstJ);
+  if (lastJ != firstJ)
+    step += ".." + std::to_string(lastJ);
+  _Record(profile, phase, event, std::move(step));
+}
+
+static void _Record(BitonicProfile *profile, BitonicPhase phase,
+                    cl::sycl::event const &event, int i, int j) {
+  _Record(profile, phase, event, i, j, j);
+}
+
+static std::string ToString(BitonicPhase phase) {
+  switch (phase) {
+  case BitonicPhase::Transfer:
+    return "transfer";
+  case BitonicPhase::Local:
+    return "local";
+  case BitonicPhase::Global:
+    return "global";
+  }
+  return {};
+}
+
+// Device time of every phase and step, and launch overhead which is the time
+// from submission of a command to its start
+static void PrintProfile(BitonicProfile const &profile, std::ostream &os) {
+  using namespace cl::sycl;
+  using std::chrono::nanoseconds;
+  auto Duration = [](event const &e) {
+    return nanoseconds(
+        e.get_profiling_info<info::event_profiling::command_end>() -
+        e.get_profiling_info<info::event_profiling::command_start>());
+  };
+  auto Latency = [](event const &e) {
+    return nanoseconds(
+        e.get_profiling_info<info::event_profiling::command_start>() -
+        e.get_profiling_info<info::event_profiling::command_submit>());
+  };
+
+  auto phases = std::vector<BitonicPhase>{
+      BitonicPhase::Transfer, BitonicPhase::Local, BitonicPhase::Global};
+  for (auto phase : phases) {
+    auto time = nanoseconds{0};
+    auto nCommands = size_t{0};
+    for (auto const &command : profile.commands)
+      if (command.phase == phase) {
+        time += Duration(command.event);
+        ++nCommands;
+      }
+    os << "  " << ToString(phase) << ": " << (time.count() / 1000)
+       << " microseconds in " << nCommands << " commands" << std::endl;
+  }
+
+  auto latency = nanoseconds{0};
+  for (auto const &command : profile.commands)
+    latency += Latency(command.event);
+  auto nCommands = std::max<size_t>(profile.commands.size(), 1);
+  os << "  launch overhead: " << (latency.count() / 1000)
+     << " microseconds, " << (latency.count() / nCommands / 1000)
+     << " per command" << std::endl;
+
+  // Commands of the same phase and step are summed when a profile is shared
+  // by several sorts
+  auto steps = std::vector<std::pair<BitonicProfile::Command, nanoseconds>>();
+  for (auto const &command : profile.commands) {
+    auto found = std::find_if(steps.begin(), steps.end(), [&](auto &step) {
+      return step.first.phase == command.phase &&
+             step.first.step == command.step;
+    });
+    if (found == steps.end())
+      found = steps.insert(steps.end(), {command, nanoseconds{0}});
+    found->second += Duration(command.event);
+  }
+  for (auto const &[command, time] : steps)
+    os << "    " << ToString(command.phase) << " " << command.step << ": "
+       << (time.count() / 1000) << " microseconds" << std::endl;
+}
+
+// Sorts vec in USM memory with sort(data, size, depEvents, profile) recording
+// copies to and from the device as transfers, device memory comes from pool
+// if given
+template <typename T, typename Sort>
+static BitonicProfile ProfileSort(cl::sycl::queue &queue, std::vector<T> &vec,
+                                  Sort &&sort, UsmPool *pool = nullptr) {
+  using namespace cl::sycl;
+  auto profile = BitonicProfile{};
+  auto size = vec.size();
+  auto *data = UsmAllocate<T>(queue, pool, size);
+  auto copied = queue.submit(
+      [&](handler &h) { h.memcpy(data, vec.data(), size * sizeof(T)); });
+  _Record(&profile, BitonicPhase::Transfer, copied, "copy in");
+  auto sorted = sort(data, size, std::vector<event>{copied}, &profile);
+  auto copiedBack = queue.submit([&](handler &h) {
+    h.depends_on(sorted);
+    h.memcpy(vec.data(), data, size * sizeof(T));
+  });
+  _Record(&profile, BitonicPhase::Transfer, copiedBack, "copy out");
+  copiedBack.wait();
+  UsmFree(queue, pool, data);
+  return profile;
+}
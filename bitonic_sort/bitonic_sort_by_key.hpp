@@ -0,0 +1,241 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+
+#include "../utils.hpp"
+#include "bitonic_sort_local.hpp"
+
+// How keys and values are moved during the sort
+// SoA: keys and values are kept in separate arrays and swapped together
+// Packed: each key is packed with its 32-bit index into 64-bit word, the words
+// are sorted, then values are gathered by the sorted indices. The sort is
+// stable in this case since equal keys are ordered by their indices.
+enum class KeyValueLayout { SoA, Packed };
+
+template <typename K, typename Compare> class BitonicPackKernel;
+template <typename K, typename Compare> class BitonicUnpackKernel;
+template <typename V> class BitonicGatherKernel;
+class BitonicIotaKernel;
+
+// Key with its value, the element of the SoA layout in local memory and in
+// registers of BitonicSortLocal
+template <typename K, typename V> struct KeyValue {
+  K key;
+  V value;
+};
+
+// Orders key-value pairs by compare of their keys
+template <typename K, typename V, typename Compare> struct _CompareKeys {
+  Compare compare;
+
+  bool operator()(KeyValue<K, V> const &lhs, KeyValue<K, V> const &rhs) const {
+    return compare(lhs.key, rhs.key);
+  }
+};
+
+// Accessors of keys and values indexed as one array of KeyValue: elements are
+// read as a KeyValue, and writes and swaps go to both accessors
+template <typename K, typename V, typename Keys, typename Values>
+struct _KeyValueZip {
+  Keys keys;
+  Values values;
+
+  struct Reference {
+    Keys const &keys;
+    Values const &values;
+    size_t i;
+
+    operator KeyValue<K, V>() const { return {keys[i], values[i]}; }
+
+    Reference const &operator=(KeyValue<K, V> const &keyValue) const {
+      keys[i] = keyValue.key;
+      values[i] = keyValue.value;
+      return *this;
+    }
+
+    friend void swap(Reference lhs, Reference rhs) {
+      std::swap(lhs.keys[lhs.i], rhs.keys[rhs.i]);
+      std::swap(lhs.values[lhs.i], rhs.values[rhs.i]);
+    }
+  };
+
+  Reference operator[](size_t i) const { return {keys, values, i}; }
+};
+
+// Kernels of both layouts of BitonicSortByKey, the packed one also sorts a
+// buffer of cl_ulong with BitonicSortLocal, see PrebuildKernels
+template <typename K, typename V, typename Compare = Less,
+          typename Index = cl::sycl::cl_uint>
+using BitonicSortByKeyKernels = KernelList<
+    BitonicSortLocalKernel<KeyValue<K, V>, false, _CompareKeys<K, V, Compare>>,
+    BitonicPartGlobalKernel<KeyValue<K, V>, false,
+                            _CompareKeys<K, V, Compare>, Index>,
+    BitonicFusedGlobalKernel<KeyValue<K, V>, false,
+                             _CompareKeys<K, V, Compare>, 1, Index>,
+    BitonicSortLocalKernel<cl::sycl::cl_ulong, false, Less>,
+    BitonicPartGlobalKernel<cl::sycl::cl_ulong, false, Less, Index>,
+    BitonicFusedGlobalKernel<cl::sycl::cl_ulong, false, Less, 1, Index>,
+    BitonicPackKernel<K, Compare>, BitonicUnpackKernel<K, Compare>,
+    BitonicGatherKernel<V>>;
+
+// BitonicSortLocal on KeyValue elements of both buffers, every move of a key
+// is repeated on its value
+template <typename K, typename V, typename Compare = Less>
+static void BitonicSortByKeySoA(cl::sycl::queue &queue,
+                                cl::sycl::buffer<K, 1> &keys,
+                                cl::sycl::buffer<V, 1> &values,
+                                Compare compare = {}) {
+  using namespace cl::sycl;
+  auto size = keys.get_count();
+  assert(values.get_count() == size);
+  if (size <= 1)
+    return;
+  // Tuned configurations are for BitonicSortLocal on single values only
+  auto config =
+      GetDefaultBitonicLocalConfig(queue.get_device(), sizeof(KeyValue<K, V>));
+  _BitonicSortLocal<1, KeyValue<K, V>>(
+      queue, size,
+      [&keys, &values](handler &h) {
+        auto keysAccess = keys.template get_access<access::mode::read_write>(h);
+        auto valuesAccess =
+            values.template get_access<access::mode::read_write>(h);
+        return _KeyValueZip<K, V, decltype(keysAccess), decltype(valuesAccess)>{
+            keysAccess, valuesAccess};
+      },
+      {}, nullptr, _CompareKeys<K, V, Compare>{compare}, &config);
+}
+
+// Sorts keys and writes the permutation into indices:
+// sorted keys[i] == original keys[indices[i]]. Keys are ordered by their bits
+// of ToOrderedBits, complemented for Greater, so equal keys keep the order of
+// their indices.
+template <typename K, typename Compare = Less>
+static void
+BitonicArgSortPacked(cl::sycl::queue &queue, cl::sycl::buffer<K, 1> &keys,
+                     cl::sycl::buffer<cl::sycl::cl_uint, 1> &indices) {
+  using namespace cl::sycl;
+  static_assert(sizeof(K) == sizeof(cl_uint),
+                "Only 32-bit keys can be packed with the index");
+  static_assert(std::is_same_v<Compare, Less> ||
+                    std::is_same_v<Compare, Greater>,
+                "Packed layout supports Less and Greater only");
+  auto constexpr isGreater = std::is_same_v<Compare, Greater>;
+  auto size = keys.get_count();
+  assert(indices.get_count() == size);
+  assert(size <= (size_t{1} << 32));
+  auto packed = buffer<cl_ulong, 1>{range<1>{size}};
+
+  queue.submit([&](handler &h) {
+    auto keysAccess = keys.template get_access<access::mode::read>(h);
+    auto packedAccess =
+        packed.template get_access<access::mode::discard_write>(h);
+    h.parallel_for<BitonicPackKernel<K, Compare>>(
+        range<1>{size}, [=](id<1> id) {
+          auto bits = static_cast<cl_uint>(ToOrderedBits(keysAccess[id]));
+          packedAccess[id] =
+              (static_cast<cl_ulong>(isGreater ? ~bits : bits) << 32) | id[0];
+        });
+  });
+  BitonicSortLocal(queue, packed);
+  queue.submit([&](handler &h) {
+    auto packedAccess = packed.template get_access<access::mode::read>(h);
+    auto keysAccess = keys.template get_access<access::mode::discard_write>(h);
+    auto indicesAccess =
+        indices.template get_access<access::mode::discard_write>(h);
+    h.parallel_for<BitonicUnpackKernel<K, Compare>>(
+        range<1>{size}, [=](id<1> id) {
+          auto word = packedAccess[id];
+          auto bits = static_cast<cl_uint>(word >> 32);
+          keysAccess[id] = FromOrderedBits<K>(isGreater ? ~bits : bits);
+          indicesAccess[id] = static_cast<cl_uint>(word);
+        });
+  });
+}
+
+template <typename K, typename V, typename Compare = Less>
+static void BitonicSortByKeyPacked(cl::sycl::queue &queue,
+                                   cl::sycl::buffer<K, 1> &keys,
+                                   cl::sycl::buffer<V, 1> &values) {
+  using namespace cl::sycl;
+  auto size = keys.get_count();
+  assert(values.get_count() == size);
+  auto indices = buffer<cl_uint, 1>{range<1>{size}};
+  auto unsorted = buffer<V, 1>{range<1>{size}};
+  BitonicArgSortPacked<K, Compare>(queue, keys, indices);
+  queue.submit([&](handler &h) {
+    auto valuesAccess = values.template get_access<access::mode::read>(h);
+    auto unsortedAccess =
+        unsorted.template get_access<access::mode::discard_write>(h);
+    h.copy(valuesAccess, unsortedAccess);
+  });
+  queue.submit([&](handler &h) {
+    auto indicesAccess = indices.template get_access<access::mode::read>(h);
+    auto unsortedAccess = unsorted.template get_access<access::mode::read>(h);
+    auto valuesAccess =
+        values.template get_access<access::mode::discard_write>(h);
+    h.parallel_for<BitonicGatherKernel<V>>(range<1>{size}, [=](id<1> id) {
+      valuesAccess[id] = unsortedAccess[indicesAccess[id]];
+    });
+  });
+}
+
+template <typename K, typename V, typename Compare = Less>
+static void BitonicSortByKey(cl::sycl::queue &queue, std::vector<K> &keys,
+                             std::vector<V> &values,
+                             KeyValueLayout layout = KeyValueLayout::SoA,
+                             Compare compare = {}) {
+  using namespace cl::sycl;
+  assert(keys.size() == values.size());
+  if (keys.size() <= 1)
+    return;
+  auto keysBuf = buffer{keys};
+  auto valuesBuf = buffer{values};
+  if (layout == KeyValueLayout::SoA)
+    BitonicSortByKeySoA(queue, keysBuf, valuesBuf, compare);
+  else
+    BitonicSortByKeyPacked<K, V, Compare>(queue, keysBuf, valuesBuf);
+  queue.wait();
+  keysBuf.template get_access<access::mode::read_write>();
+  valuesBuf.template get_access<access::mode::read_write>();
+}
+
+// Returns indices of keys in sorted order, keys are left unchanged
+template <typename K, typename Compare = Less>
+static std::vector<cl::sycl::cl_uint>
+BitonicArgSort(cl::sycl::queue &queue, std::vector<K> const &keys,
+               KeyValueLayout layout = KeyValueLayout::Packed,
+               Compare compare = {}) {
+  using namespace cl::sycl;
+  auto size = keys.size();
+  auto indices = std::vector<cl_uint>(size);
+  if (size <= 1) {
+    std::iota(indices.begin(), indices.end(), 0);
+    return indices;
+  }
+  {
+    auto keysBuf = buffer<K, 1>{range<1>{size}};
+    auto indicesBuf = buffer{indices};
+    queue.submit([&](handler &h) {
+      auto keysAccess =
+          keysBuf.template get_access<access::mode::discard_write>(h);
+      h.copy(keys.data(), keysAccess);
+    });
+    if (layout == KeyValueLayout::SoA) {
+      queue.submit([&](handler &h) {
+        auto indicesAccess =
+            indicesBuf.template get_access<access::mode::discard_write>(h);
+        h.parallel_for<BitonicIotaKernel>(
+            range<1>{size}, [=](id<1> id) { indicesAccess[id] = id[0]; });
+      });
+      BitonicSortByKeySoA(queue, keysBuf, indicesBuf, compare);
+    } else
+      BitonicArgSortPacked<K, Compare>(queue, keysBuf, indicesBuf);
+    queue.wait();
+  }
+  return indices;
+}
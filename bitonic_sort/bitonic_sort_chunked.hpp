@@ -0,0 +1,180 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "../utils.hpp"
+#include "bitonic_sort_local.hpp"
+
+struct ChunkedSortStats {
+  size_t nChunks = 0;
+  size_t bytes = 0;
+  // Busy time of every stage summed over chunks
+  // Stages of different chunks overlap, so the sum exceeds the wall time
+  std::chrono::nanoseconds copyInTime{0};
+  std::chrono::nanoseconds sortTime{0};
+  std::chrono::nanoseconds copyOutTime{0};
+  std::chrono::nanoseconds mergeTime{0};
+};
+
+static void PrintStats(ChunkedSortStats const &stats, std::ostream &os) {
+  auto Throughput = [&](std::chrono::nanoseconds time) {
+    // Bytes per nanosecond are gigabytes per second
+    return time.count() == 0 ? 0.0
+                             : static_cast<double>(stats.bytes) / time.count();
+  };
+  os << "  " << stats.nChunks << " chunks" << std::endl;
+  os << "  copy in: " << (stats.copyInTime.count() / 1000)
+     << " microseconds, " << Throughput(stats.copyInTime) << " GB/s"
+     << std::endl;
+  os << "  sort: " << (stats.sortTime.count() / 1000) << " microseconds, "
+     << Throughput(stats.sortTime) << " GB/s" << std::endl;
+  os << "  copy out: " << (stats.copyOutTime.count() / 1000)
+     << " microseconds, " << Throughput(stats.copyOutTime) << " GB/s"
+     << std::endl;
+  os << "  merge: " << (stats.mergeTime.count() / 1000) << " microseconds, "
+     << Throughput(stats.mergeTime) << " GB/s" << std::endl;
+}
+
+// K-way merge of consecutive sorted chunks of chunkSize elements
+template <typename T, typename Compare = Less>
+static void MergeSortedChunks(std::vector<T> &vec, size_t chunkSize,
+                              Compare compare = {}) {
+  auto size = vec.size();
+  if (chunkSize >= size)
+    return;
+  // Current position and end of each chunk, the first element on top
+  using Cursor = std::pair<size_t, size_t>;
+  auto Greater = [&vec, compare](Cursor const &lhs, Cursor const &rhs) {
+    return compare(vec[rhs.first], vec[lhs.first]);
+  };
+  auto heap =
+      std::priority_queue<Cursor, std::vector<Cursor>, decltype(Greater)>{
+          Greater};
+  for (auto start = size_t{0}; start < size; start += chunkSize)
+    heap.emplace(start, std::min(start + chunkSize, size));
+
+  auto result = std::vector<T>();
+  result.reserve(size);
+  while (!heap.empty()) {
+    auto [index, end] = heap.top();
+    heap.pop();
+    result.push_back(vec[index]);
+    if (++index != end)
+      heap.emplace(index, end);
+  }
+  vec = std::move(result);
+}
+
+// Sorts arrays larger than device memory
+// The array is split into chunks of chunkSize elements (by default as large
+// as device allows), each chunk is sorted with BitonicSortLocal and the chunks
+// are merged on the host. Two chunks are on the device at once, so copying
+// of one chunk overlaps with sorting of the other, and the host moves a chunk
+// to or from its pinned staging buffer meanwhile.
+template <typename T, typename Compare = Less>
+static ChunkedSortStats BitonicSortChunked(cl::sycl::queue &queue,
+                                           std::vector<T> &vec,
+                                           size_t chunkSize = 0,
+                                           Compare compare = {}) {
+  using namespace cl::sycl;
+  using std::chrono::nanoseconds;
+  auto stats = ChunkedSortStats{};
+  auto size = vec.size();
+  if (size <= 1)
+    return stats;
+
+  auto device = queue.get_device();
+  if (chunkSize == 0) {
+    // Leave a half of the memory to the runtime and other allocations
+    auto maxAlloc = device.get_info<info::device::max_mem_alloc_size>();
+    auto globalMem = device.get_info<info::device::global_mem_size>();
+    chunkSize = std::min<size_t>(maxAlloc, globalMem / 4) / sizeof(T);
+  }
+  chunkSize = std::min(chunkSize, size);
+  auto nChunks = (size + chunkSize - 1) / chunkSize;
+  auto nSlots = std::min<size_t>(nChunks, 2);
+  stats.nChunks = nChunks;
+  stats.bytes = size * sizeof(T);
+
+  // Default queue is out-of-order, so only the dependencies below order
+  // the commands. Profiling gives the time of each stage.
+  auto profilingQueue = cl::sycl::queue{queue.get_context(), device,
+                                        property::queue::enable_profiling{}};
+  // Copies between the device and pageable memory are staged and serialized
+  // by most runtimes, so every slot has a pinned host buffer, and chunks go
+  // between it and vec on the host
+  auto slots = std::vector<T *>(nSlots);
+  auto stagingBuffers = std::vector<T *>(nSlots);
+  for (auto i = size_t{0}; i != nSlots; ++i) {
+    slots[i] = malloc_device<T>(chunkSize, profilingQueue);
+    stagingBuffers[i] = malloc_host<T>(chunkSize, profilingQueue);
+  }
+
+  auto copyIn = std::vector<event>(nChunks);
+  auto sorted = std::vector<event>(nChunks);
+  auto copyOut = std::vector<event>(nChunks);
+  // Kernels of every chunk's sort
+  auto profiles = std::vector<BitonicProfile>(nChunks);
+  auto ChunkRange = [&](size_t chunk) {
+    auto offset = chunk * chunkSize;
+    return std::pair{vec.begin() + offset,
+                     vec.begin() + std::min(offset + chunkSize, size)};
+  };
+  // Slot is free when the chunk it held before is copied out
+  auto CopyBack = [&](size_t chunk) {
+    copyOut[chunk].wait();
+    auto [first, last] = ChunkRange(chunk);
+    std::copy(stagingBuffers[chunk % nSlots],
+              stagingBuffers[chunk % nSlots] + (last - first), first);
+  };
+  for (auto chunk = size_t{0}; chunk != nChunks; ++chunk) {
+    if (chunk >= nSlots)
+      CopyBack(chunk - nSlots);
+    auto [first, last] = ChunkRange(chunk);
+    auto chunkBytes = static_cast<size_t>(last - first) * sizeof(T);
+    auto *slot = slots[chunk % nSlots];
+    auto *staging = stagingBuffers[chunk % nSlots];
+    std::copy(first, last, staging);
+    copyIn[chunk] = profilingQueue.submit(
+        [&](handler &h) { h.memcpy(slot, staging, chunkBytes); });
+    sorted[chunk] =
+        BitonicSortLocal(profilingQueue, slot, chunkBytes / sizeof(T),
+                         {copyIn[chunk]}, &profiles[chunk], compare);
+    copyOut[chunk] = profilingQueue.submit([&](handler &h) {
+      h.depends_on(sorted[chunk]);
+      h.memcpy(staging, slot, chunkBytes);
+    });
+  }
+  for (auto chunk = nChunks - nSlots; chunk != nChunks; ++chunk)
+    CopyBack(chunk);
+  for (auto i = size_t{0}; i != nSlots; ++i) {
+    free(slots[i], profilingQueue);
+    free(stagingBuffers[i], profilingQueue);
+  }
+
+  auto Start = [](event const &e) {
+    return e.get_profiling_info<info::event_profiling::command_start>();
+  };
+  auto End = [](event const &e) {
+    return e.get_profiling_info<info::event_profiling::command_end>();
+  };
+  for (auto chunk = size_t{0}; chunk != nChunks; ++chunk) {
+    stats.copyInTime += nanoseconds(End(copyIn[chunk]) - Start(copyIn[chunk]));
+    // Copies of other chunks may run between the kernels of a sort, so only
+    // the kernels are counted
+    for (auto const &command : profiles[chunk].commands)
+      stats.sortTime += nanoseconds(End(command.event) - Start(command.event));
+    stats.copyOutTime +=
+        nanoseconds(End(copyOut[chunk]) - Start(copyOut[chunk]));
+  }
+  stats.mergeTime = std::chrono::duration_cast<nanoseconds>(Utility::Benchmark(
+      [&]() { MergeSortedChunks(vec, chunkSize, compare); }));
+  return stats;
+}
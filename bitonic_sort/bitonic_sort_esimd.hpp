@@ -4,49 +4,100 @@
 #include <CL/sycl/INTEL/esimd.hpp>
 
 #include <algorithm>
+#include <type_traits>
+#include <vector>
 
 #include "../utils.hpp"
+#include "bitonic_profile.hpp"
 
-template <typename T>
-static void BitonicSortESIMD(cl::sycl::queue &queue, std::vector<T> &vec) {
+template <typename T, typename Compare> class BitonicESIMDKernel;
+
+// Kernels of BitonicSortESIMD, total orders of floating point values use the
+// ones of their ordered bits, see PrebuildKernels
+template <typename T, typename Compare = Less>
+using BitonicSortESIMDKernels = KernelList<BitonicESIMDKernel<T, Compare>>;
+
+// Compare is Less or Greater, they compare simd vectors lane by lane
+// Elements are 32-bit
+template <typename T, typename Compare>
+static void _BitonicSortESIMD(cl::sycl::queue &queue, std::vector<T> &vec,
+                              BitonicProfile *profile, Compare compare) {
   using namespace cl::sycl;
   using namespace sycl::INTEL::gpu;
-  auto constexpr SIMDSize = unsigned{16};
+  static_assert(std::is_same_v<Compare, Less> ||
+                    std::is_same_v<Compare, Greater>,
+                "ESIMD sort supports Less and Greater only");
+  // Gathers and scatters of the kernel move 32-bit elements, so 64-bit values
+  // and their ordered bits would be truncated
+  static_assert(sizeof(T) == 4, "ESIMD sort supports 32-bit elements only");
   auto constexpr TSize = sizeof(T);
+  auto constexpr SIMDSize = unsigned{16};
   auto size = vec.size();
   if (size <= SIMDSize) {
-    std::sort(vec.begin(), vec.end());
+    std::sort(vec.begin(), vec.end(), compare);
     return;
   }
-  auto original = vec;
+  // Lanes hold 32-bit indices
+  assert(NextPowerOf2(size) <= (size_t{1} << 31));
 
-  auto nLargeSteps = log2i(size);
+  // Comparators touching the padding are masked, see BitonicSortNaive
+  auto nLargeSteps = log2i(NextPowerOf2(size));
   auto buf = buffer{vec};
   for (auto i = 0; i != nLargeSteps; ++i)
-    for (auto j = 0; j != i + 1; ++j)
-      queue.submit([&](handler &h) {
+    for (auto j = 0; j != i + 1; ++j) {
+      auto nComparators = BitonicNComparators(size, size_t{2} << (i - j));
+      auto nThreads = (nComparators + SIMDSize - 1) / SIMDSize;
+      auto event = queue.submit([&](handler &h) {
         auto access = buf.template get_access<access::mode::read_write>(h);
         // Executing kernel
-        h.parallel_for<class BitonicESIMDKernel>(
-            range<1>{size / SIMDSize / 2}, [=](id<1> id_) SYCL_ESIMD_KERNEL {
+        h.parallel_for<BitonicESIMDKernel<T, Compare>>(
+            range<1>{nThreads}, [=](id<1> id_) SYCL_ESIMD_KERNEL {
               auto id = id_[0] * SIMDSize;
               auto boxSize = 2 << (i - j);
               auto halfBoxSize = boxSize / 2;
-              auto bigBoxSize = 2 << i;
               auto isSortPhase = static_cast<bool>(j);
               auto ids = simd<unsigned, SIMDSize>(id, 1);
               auto id0s = ((ids / halfBoxSize) * boxSize) +
                           (ids - (ids / halfBoxSize) * halfBoxSize);
-              auto id1s = id0s + halfBoxSize;
+              auto id1s = isSortPhase ? id0s + halfBoxSize
+                                      : id0s ^ (boxSize - 1);
+              // Lanes outside of the array compare the last element with
+              // itself, so they never swap
+              auto last = simd<unsigned, SIMDSize>(size - 1);
+              id0s.merge(last, id0s > last);
+              id1s.merge(id0s, id1s > last);
               auto data0 = gather<T, SIMDSize>(access, id0s);
               auto data1 = gather<T, SIMDSize>(access, id1s);
-              auto id0sparity = id0s / bigBoxSize;
-              id0sparity = id0sparity - (id0sparity / 2) * 2;
-              auto conds = (id0sparity == 0) == (data0 > data1);
+              auto conds = compare(data1, data0);
               scatter<T, SIMDSize>(access, data1, id0s, 0, conds);
               scatter<T, SIMDSize>(access, data0, id1s, 0, conds);
             });
       });
+      _Record(profile, BitonicPhase::Global, event, i, j);
+    }
   queue.wait();
   buf.template get_access<access::mode::read_write>();
 }
+
+// Total orders of floating point values sort the ordered bits instead
+template <typename T, typename Compare = Less>
+static void BitonicSortESIMD(cl::sycl::queue &queue, std::vector<T> &vec,
+                             BitonicProfile *profile = nullptr,
+                             Compare compare = {}) {
+  auto constexpr isTotalOrderLess = std::is_same_v<Compare, TotalOrderLess>;
+  if constexpr (isTotalOrderLess ||
+                std::is_same_v<Compare, TotalOrderGreater>) {
+    using Direction = std::conditional_t<isTotalOrderLess, Less, Greater>;
+    if constexpr (std::is_floating_point_v<T>) {
+      auto bits = std::vector<OrderedBitsType<T>>(vec.size());
+      std::transform(vec.begin(), vec.end(), bits.begin(),
+                     [](T value) { return ToOrderedBits(value); });
+      _BitonicSortESIMD(queue, bits, profile, Direction{});
+      std::transform(bits.begin(), bits.end(), vec.begin(),
+                     [](auto bits) { return FromOrderedBits<T>(bits); });
+    } else
+      _BitonicSortESIMD(queue, vec, profile, Direction{});
+  } else
+    _BitonicSortESIMD(queue, vec, profile, compare);
+}
+
@@ -2,39 +2,153 @@
 
 #include <CL/sycl.hpp>
 
+#include <type_traits>
+#include <vector>
+
 #include "../utils.hpp"
+#include "bitonic_profile.hpp"
+#include "bitonic_sort_local.hpp"
+
+template <typename T, bool IsUSM, typename Compare, typename Index>
+class BitonicHierKernel;
+template <typename T, bool IsUSM, typename Compare, typename Index>
+class BitonicHierNDKernel;
+
+// Kernels of the sort on buffers and USM, see PrebuildKernels
+template <typename T, typename Compare = Less,
+          typename Index = cl::sycl::cl_uint>
+using BitonicSortHierKernels =
+    KernelList<BitonicHierKernel<T, false, Compare, Index>,
+               BitonicHierKernel<T, true, Compare, Index>>;
 
-template <typename T>
-static void BitonicSortHier(cl::sycl::queue &queue, std::vector<T> &vec) {
+// Kernels of BitonicSortHierND, see PrebuildKernels
+template <typename T, typename Compare = Less,
+          typename Index = cl::sycl::cl_uint>
+using BitonicSortHierNDKernels =
+    KernelList<BitonicHierNDKernel<T, false, Compare, Index>,
+               BitonicHierNDKernel<T, true, Compare, Index>>;
+
+// Submits all kernels of the sort, see _BitonicSortLocal for the parameters
+// Kind selects the launch form of the steps, see BitonicKernelKind
+template <BitonicKernelKind Kind, typename T, typename DataGetter,
+          typename Compare>
+static cl::sycl::event
+_BitonicSortHier(cl::sycl::queue &queue, size_t size, DataGetter getData,
+                 std::vector<cl::sycl::event> const &depEvents,
+                 BitonicProfile *profile, Compare compare) {
   using namespace cl::sycl;
-  auto SIMDSize = unsigned{32};
-  if (vec.size() <= SIMDSize)
-    SIMDSize = vec.size() / 2;
+  auto constexpr isUSM =
+      std::is_pointer_v<std::invoke_result_t<DataGetter, handler &>>;
+  if (size <= 1)
+    return JoinEvents(queue, depEvents);
+  auto SIMDSize = size_t{32};
+  if (size <= SIMDSize)
+    SIMDSize = size / 2;
+
+  // Comparators touching the padding are masked, see BitonicSortNaive
+  auto nLargeSteps = static_cast<cl_int>(log2i(NextPowerOf2(size)));
+  auto events = depEvents;
 
+  for (auto i = 0; i != nLargeSteps; ++i)
+    for (auto j = 0; j != i + 1; ++j) {
+      auto nComparators = BitonicNComparators(size, size_t{2} << (i - j));
+      auto nWorkGroups = (nComparators + SIMDSize - 1) / SIMDSize;
+      events = {WithIndexType(size, [&](auto index) {
+        using Index = decltype(index);
+        return queue.submit([&](handler &h) {
+          h.depends_on(events);
+          auto access = getData(h);
+          auto n = static_cast<Index>(size);
+          auto nIds = static_cast<Index>(nComparators);
+          auto Step = [=](size_t globalId) {
+            auto id = static_cast<Index>(globalId);
+            if (id >= nIds)
+              return;
+            auto boxSize = Index{2} << (i - j);
+            auto isSortPhase = static_cast<bool>(j);
+            auto id0 = ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
+            auto id1 = isSortPhase ? id0 + boxSize / 2 : id0 ^ (boxSize - 1);
+            if (id1 < n && compare(access[id1], access[id0]))
+              std::swap(access[id0], access[id1]);
+          };
+          if constexpr (Kind == BitonicKernelKind::NDRange)
+            h.parallel_for<BitonicHierNDKernel<T, isUSM, Compare, Index>>(
+                nd_range<1>{range<1>{nWorkGroups * SIMDSize},
+                            range<1>{SIMDSize}},
+                [=](nd_item<1> it) { Step(it.get_global_id(0)); });
+          else
+            h.parallel_for_work_group<
+                BitonicHierKernel<T, isUSM, Compare, Index>>(
+                range<1>{nWorkGroups}, range<1>{SIMDSize}, [=](group<1> g) {
+                  g.parallel_for_work_item(
+                      [=](h_item<1> it) { Step(it.get_global_id(0)); });
+                });
+        });
+      })};
+      _Record(profile, BitonicPhase::Global, events.front(), i, j);
+    }
+  return JoinEvents(queue, events);
+}
+
+template <typename T, typename Compare = Less>
+static void BitonicSortHier(cl::sycl::queue &queue, std::vector<T> &vec,
+                            Compare compare = {}) {
+  using namespace cl::sycl;
   auto size = vec.size();
-  auto nLargeSteps = static_cast<cl_int>(log2i(size));
+  if (size <= 1)
+    return;
   auto buf = buffer{vec};
-  auto range1d = range<1>{buf.get_count() / 2};
+  _BitonicSortHier<BitonicKernelKind::Hierarchical, T>(
+      queue, size,
+      [&buf](handler &h) {
+        return buf.template get_access<access::mode::read_write>(h);
+      },
+      {}, nullptr, compare);
+  queue.wait();
+  buf.template get_access<access::mode::read_write>();
+}
 
-  for (auto i = 0; i != nLargeSteps; ++i)
-    for (auto j = 0; j != i + 1; ++j)
-      queue.submit([&](handler &h) {
-        auto access = buf.template get_access<access::mode::read_write>(h);
-        h.parallel_for_work_group<class BitonicHierKernel>(
-            range<1>{size / SIMDSize / 2}, range<1>{SIMDSize}, [=](group<1> g) {
-              g.parallel_for_work_item([=](h_item<1> it) {
-                auto id = it.get_global_id(0);
-                auto boxSize = 2 << (i - j);
-                auto isSortPhase = static_cast<bool>(j);
-                auto id0 =
-                    ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
-                auto id1 = id0 + boxSize / 2;
-                auto bigBoxSize = 2 << i;
-                if (((id0 / bigBoxSize) % 2) == (access[id0] < access[id1]))
-                  std::swap(access[id0], access[id1]);
-              });
-            });
-      });
+// Sorts size elements of USM memory
+// The result is ready when the returned event completes
+template <typename T, typename Compare = Less>
+static cl::sycl::event
+BitonicSortHier(cl::sycl::queue &queue, T *data, size_t size,
+                std::vector<cl::sycl::event> const &depEvents = {},
+                BitonicProfile *profile = nullptr, Compare compare = {}) {
+  return _BitonicSortHier<BitonicKernelKind::Hierarchical, T>(
+      queue, size, [data](cl::sycl::handler &) { return data; }, depEvents,
+      profile, compare);
+}
+
+// Overloads of BitonicSortHier with nd_range kernels of the same work group
+// size, without the barrier the runtime may put after parallel_for_work_item
+
+template <typename T, typename Compare = Less>
+static void BitonicSortHierND(cl::sycl::queue &queue, std::vector<T> &vec,
+                              Compare compare = {}) {
+  using namespace cl::sycl;
+  auto size = vec.size();
+  if (size <= 1)
+    return;
+  auto buf = buffer{vec};
+  _BitonicSortHier<BitonicKernelKind::NDRange, T>(
+      queue, size,
+      [&buf](handler &h) {
+        return buf.template get_access<access::mode::read_write>(h);
+      },
+      {}, nullptr, compare);
   queue.wait();
   buf.template get_access<access::mode::read_write>();
 }
+
+// Sorts size elements of USM memory
+// The result is ready when the returned event completes
+template <typename T, typename Compare = Less>
+static cl::sycl::event
+BitonicSortHierND(cl::sycl::queue &queue, T *data, size_t size,
+                  std::vector<cl::sycl::event> const &depEvents = {},
+                  BitonicProfile *profile = nullptr, Compare compare = {}) {
+  return _BitonicSortHier<BitonicKernelKind::NDRange, T>(
+      queue, size, [data](cl::sycl::handler &) { return data; }, depEvents,
+      profile, compare);
+}
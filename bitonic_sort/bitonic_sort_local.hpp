@@ -3,31 +3,301 @@
 #include <CL/sycl.hpp>
 
 #include <algorithm>
+#include <type_traits>
+#include <vector>
 
 #include "../utils.hpp"
+#include "bitonic_local_config.hpp"
+#include "bitonic_profile.hpp"
 
-template <typename T>
-static void BitonicSortLocal(cl::sycl::queue &queue, std::vector<T> &vec) {
+// Kernels are instantiated both for buffers and USM pointers, global ones
+// also for 32-bit and 64-bit indices, see WithIndexType
+template <typename T, bool IsUSM, typename Compare>
+class BitonicSortLocalKernel;
+template <typename T, bool IsUSM, typename Compare>
+class BitonicSortLocalNDKernel;
+template <typename T, bool IsUSM, typename Compare, typename Index>
+class BitonicPartGlobalKernel;
+template <typename T, bool IsUSM, typename Compare, int NSteps, typename Index>
+class BitonicFusedGlobalKernel;
+
+// Kernels of BitonicSortLocal<NFusedSteps> on buffers and USM, see
+// PrebuildKernels
+template <typename T, typename Compare = Less, int NFusedSteps = 1,
+          typename Index = cl::sycl::cl_uint>
+using BitonicSortLocalKernels = KernelList<
+    BitonicSortLocalKernel<T, false, Compare>,
+    BitonicSortLocalKernel<T, true, Compare>,
+    BitonicPartGlobalKernel<T, false, Compare, Index>,
+    BitonicPartGlobalKernel<T, true, Compare, Index>,
+    BitonicFusedGlobalKernel<T, false, Compare, NFusedSteps, Index>,
+    BitonicFusedGlobalKernel<T, true, Compare, NFusedSteps, Index>>;
+
+// Kernels of BitonicSortLocalND<NFusedSteps>, see PrebuildKernels
+template <typename T, typename Compare = Less, int NFusedSteps = 1,
+          typename Index = cl::sycl::cl_uint>
+using BitonicSortLocalNDKernels = KernelList<
+    BitonicSortLocalNDKernel<T, false, Compare>,
+    BitonicSortLocalNDKernel<T, true, Compare>,
+    BitonicPartGlobalKernel<T, false, Compare, Index>,
+    BitonicPartGlobalKernel<T, true, Compare, Index>,
+    BitonicFusedGlobalKernel<T, false, Compare, NFusedSteps, Index>,
+    BitonicFusedGlobalKernel<T, true, Compare, NFusedSteps, Index>>;
+
+// Launch form of work group kernels: hierarchical with a
+// parallel_for_work_item per step, or nd_range with explicit barriers
+enum class BitonicKernelKind { Hierarchical, NDRange };
+
+// Performs small step j of large step i in global memory, a kernel per step
+template <typename T, typename DataGetter, typename Compare>
+static cl::sycl::event
+_BitonicGlobalStep(cl::sycl::queue &queue, size_t size, DataGetter getData,
+                   int i, int j, std::vector<cl::sycl::event> const &depEvents,
+                   Compare compare) {
+  using namespace cl::sycl;
+  auto constexpr isUSM =
+      std::is_pointer_v<std::invoke_result_t<DataGetter, handler &>>;
+  auto nComparators = BitonicNComparators(size, size_t{2} << (i - j));
+  return WithIndexType(size, [&](auto index) {
+    using Index = decltype(index);
+    return queue.submit([&](handler &h) {
+      h.depends_on(depEvents);
+      auto global = getData(h);
+      auto n = static_cast<Index>(size);
+      h.parallel_for<BitonicPartGlobalKernel<T, isUSM, Compare, Index>>(
+          range<1>{nComparators}, [=](id<1> id_) {
+            auto id = static_cast<Index>(id_[0]);
+            auto boxSize = Index{2} << (i - j);
+            auto isSortPhase = static_cast<bool>(j);
+            auto id0 = ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
+            auto id1 = isSortPhase ? id0 + boxSize / 2 : id0 ^ (boxSize - 1);
+            // Element references of getData may have their own swap
+            using std::swap;
+            if (id1 < n && compare(global[id1], global[id0]))
+              swap(global[id0], global[id1]);
+          });
+    });
+  });
+}
+
+// Performs nSteps consecutive small steps (except the first one of a large
+// step) starting with boxes of boxSize elements in a single kernel.
+// Each work item loads all elements its comparators touch into registers.
+// These are 2^nSteps elements placed with the stride of the smallest half box.
+template <int NSteps, typename T, typename DataGetter, typename Compare>
+static cl::sycl::event
+_BitonicFusedGlobalSteps(cl::sycl::queue &queue, size_t size,
+                         DataGetter getData, size_t boxSize, int nSteps,
+                         std::vector<cl::sycl::event> const &depEvents,
+                         Compare compare) {
+  using namespace cl::sycl;
+  if constexpr (NSteps > 1)
+    if (nSteps < NSteps)
+      return _BitonicFusedGlobalSteps<NSteps - 1, T>(
+          queue, size, getData, boxSize, nSteps, depEvents, compare);
+  auto constexpr isUSM =
+      std::is_pointer_v<std::invoke_result_t<DataGetter, handler &>>;
+  auto constexpr nRegisters = 1 << NSteps;
+  auto stride = boxSize / nRegisters;
+  auto nWorkItems =
+      (size / boxSize) * stride + std::min(size % boxSize, stride);
+  return WithIndexType(size, [&](auto index) {
+    using Index = decltype(index);
+    return queue.submit([&](handler &h) {
+      h.depends_on(depEvents);
+      auto global = getData(h);
+      auto n = static_cast<Index>(size);
+      auto box = static_cast<Index>(boxSize);
+      auto step = static_cast<Index>(stride);
+      h.parallel_for<
+          BitonicFusedGlobalKernel<T, isUSM, Compare, NSteps, Index>>(
+          range<1>{nWorkItems}, [=](id<1> id_) {
+            auto id = static_cast<Index>(id_[0]);
+            auto start = (id / step) * box + id % step;
+            T registers[nRegisters];
+            for (auto i = 0; i != nRegisters; ++i)
+              if (start + i * step < n)
+                registers[i] = global[start + i * step];
+            for (auto j = 0; j != NSteps; ++j) {
+              auto halfBox = nRegisters >> (j + 1);
+              for (auto i = 0; i != nRegisters / 2; ++i) {
+                auto i0 = ((i / halfBox) * halfBox * 2) + (i % halfBox);
+                auto i1 = i0 + halfBox;
+                if (start + i1 * step < n &&
+                    compare(registers[i1], registers[i0]))
+                  std::swap(registers[i0], registers[i1]);
+              }
+            }
+            for (auto i = 0; i != nRegisters; ++i)
+              if (start + i * step < n)
+                global[start + i * step] = registers[i];
+          });
+    });
+  });
+}
+
+// Sorts tiles of WGSize * nElementsPerWorkItem elements in local memory with
+// a parallel_for_work_item per small step. All large steps of the tile are
+// done, or only the small steps of the last one in the continuation of the
+// global phase.
+template <typename T, typename DataGetter, typename Compare>
+static cl::sycl::event
+_BitonicLocalStepsHier(cl::sycl::queue &queue, size_t size, DataGetter getData,
+                       size_t WGSize, size_t nElementsPerWorkItem,
+                       int nWGLargeSteps, bool isContinuation,
+                       std::vector<cl::sycl::event> const &depEvents,
+                       Compare compare) {
   using namespace cl::sycl;
   using LocalAccess =
       accessor<T, 1, access::mode::read_write, access::target::local>;
-  using GlobalAccess =
-      accessor<T, 1, access::mode::read_write, access::target::global_buffer>;
-  auto size = vec.size();
-  if (size <= 1)
-    return;
+  auto constexpr isUSM =
+      std::is_pointer_v<std::invoke_result_t<DataGetter, handler &>>;
+  auto nOpsPerWorkItem =
+      nElementsPerWorkItem / /*number of arguments of swap operation*/ 2;
+  auto WGElements = WGSize * nElementsPerWorkItem;
+  // The last work group may get an incomplete chunk
+  auto nWorkGroups = (size + WGElements - 1) / WGElements;
+  auto firstLargeStep = isContinuation ? nWGLargeSteps - 1 : 0;
+  return queue.submit([&](handler &h) {
+    h.depends_on(depEvents);
+    auto global = getData(h);
+    auto local = LocalAccess(range<1>{WGElements}, h);
+    h.parallel_for_work_group<BitonicSortLocalKernel<T, isUSM, Compare>>(
+        range<1>{nWorkGroups}, range<1>{WGSize}, [=](group<1> g) {
+          auto startIndex = g.get_id(0) * WGElements;
+          auto nElements = std::min<size_t>(WGElements, size - startIndex);
+          // Load items from global memory
+          g.parallel_for_work_item([=](h_item<1> it) {
+            auto localStart = it.get_local_id()[0] * nElementsPerWorkItem;
+            for (auto i = size_t{0}; i != nElementsPerWorkItem; ++i) {
+              auto localIndex = localStart + i;
+              if (localIndex < nElements)
+                local[localIndex] = global[startIndex + localIndex];
+            }
+          });
 
-  auto buf = buffer{vec};
+          // Sort
+          for (auto i = firstLargeStep; i != nWGLargeSteps; ++i) {
+            for (auto j = 0; j != i + 1; ++j)
+              g.parallel_for_work_item([=](h_item<1> it) {
+                auto start = it.get_local_id()[0] * nOpsPerWorkItem;
+                auto boxSize = size_t{2} << (i - j);
+                // First small step of a large step compares mirrored
+                // elements, in the continuation of global steps it was
+                // already done in global memory
+                auto isSortPhase = isContinuation || j != 0;
+                for (auto el = size_t{0}; el != nOpsPerWorkItem; ++el) {
+                  auto id = start + el;
+                  auto id0 =
+                      ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
+                  auto id1 =
+                      isSortPhase ? id0 + boxSize / 2 : id0 ^ (boxSize - 1);
+                  if (id1 < nElements && compare(local[id1], local[id0]))
+                    std::swap(local[id0], local[id1]);
+                }
+              });
+          }
+
+          // Load items to global memory
+          g.parallel_for_work_item([=](h_item<1> it) {
+            auto localStart = it.get_local_id()[0] * nElementsPerWorkItem;
+            for (auto i = size_t{0}; i != nElementsPerWorkItem; ++i) {
+              auto localIndex = localStart + i;
+              if (localIndex < nElements)
+                global[startIndex + localIndex] = local[localIndex];
+            }
+          });
+        });
+  });
+}
+
+// Same steps as _BitonicLocalStepsHier in an nd_range kernel, so backends
+// that outline every parallel_for_work_item and put barriers around them
+// run a single loop with an explicit barrier per small step, and the loop
+// state stays in private memory of the work items. Loads and stores are
+// strided by the work group size, so neighbouring work items access
+// neighbouring elements.
+template <typename T, typename DataGetter, typename Compare>
+static cl::sycl::event
+_BitonicLocalStepsND(cl::sycl::queue &queue, size_t size, DataGetter getData,
+                     size_t WGSize, size_t nElementsPerWorkItem,
+                     int nWGLargeSteps, bool isContinuation,
+                     std::vector<cl::sycl::event> const &depEvents,
+                     Compare compare) {
+  using namespace cl::sycl;
+  using LocalAccess =
+      accessor<T, 1, access::mode::read_write, access::target::local>;
+  auto constexpr isUSM =
+      std::is_pointer_v<std::invoke_result_t<DataGetter, handler &>>;
+  auto nOpsPerWorkItem = nElementsPerWorkItem / 2;
+  auto WGElements = WGSize * nElementsPerWorkItem;
+  auto nWorkGroups = (size + WGElements - 1) / WGElements;
+  auto firstLargeStep = isContinuation ? nWGLargeSteps - 1 : 0;
+  return queue.submit([&](handler &h) {
+    h.depends_on(depEvents);
+    auto global = getData(h);
+    auto local = LocalAccess(range<1>{WGElements}, h);
+    h.parallel_for<BitonicSortLocalNDKernel<T, isUSM, Compare>>(
+        nd_range<1>{range<1>{nWorkGroups * WGSize}, range<1>{WGSize}},
+        [=](nd_item<1> it) {
+          auto startIndex = it.get_group_linear_id() * WGElements;
+          auto nElements = std::min<size_t>(WGElements, size - startIndex);
+          auto localId = it.get_local_id(0);
+          for (auto i = localId; i < nElements; i += WGSize)
+            local[i] = global[startIndex + i];
+
+          auto start = localId * nOpsPerWorkItem;
+          for (auto i = firstLargeStep; i != nWGLargeSteps; ++i)
+            for (auto j = 0; j != i + 1; ++j) {
+              it.barrier(access::fence_space::local_space);
+              auto boxSize = size_t{2} << (i - j);
+              auto isSortPhase = isContinuation || j != 0;
+              for (auto id = start; id != start + nOpsPerWorkItem; ++id) {
+                auto id0 =
+                    ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
+                auto id1 =
+                    isSortPhase ? id0 + boxSize / 2 : id0 ^ (boxSize - 1);
+                if (id1 < nElements && compare(local[id1], local[id0]))
+                  std::swap(local[id0], local[id1]);
+              }
+            }
+          it.barrier(access::fence_space::local_space);
+
+          for (auto i = localId; i < nElements; i += WGSize)
+            global[startIndex + i] = local[i];
+        });
+  });
+}
+
+// Submits all kernels of the sort, getData(handler) returns either an accessor
+// or a USM pointer to the data. Every kernel depends on the previous one, so
+// the sort works on out-of-order queues as well.
+// NFusedSteps small steps of the global phase are done by one kernel
+// compare(a, b) is true when a goes before b
+// Configuration of the local phase is GetBitonicLocalConfig unless given
+// Kind selects the kernel of the local phase, see BitonicKernelKind
+// Kernels are chained through a list of events, eventStorage keeps its
+// capacity between sorts so that they do not allocate it, see SortPlan
+template <BitonicKernelKind Kind, int NFusedSteps, typename T,
+          typename DataGetter, typename Compare>
+static cl::sycl::event
+_BitonicSortLocalWith(cl::sycl::queue &queue, size_t size, DataGetter getData,
+                      std::vector<cl::sycl::event> const &depEvents,
+                      BitonicProfile *profile, Compare compare,
+                      BitonicLocalConfig const *localConfig,
+                      std::vector<cl::sycl::event> *eventStorage = nullptr) {
+  static_assert(NFusedSteps >= 1);
+  using namespace cl::sycl;
+  if (size <= 1)
+    return JoinEvents(queue, depEvents);
 
   // Determine how much elements we can load into local memory
   // This also determines how much elements one work item will handle
-  auto workGroupSizeRaw =
-      queue.get_device().get_info<info::device::max_work_group_size>();
-  auto localMem = queue.get_device().get_info<info::device::local_mem_size>();
-  auto memPerWorkItem = localMem / workGroupSizeRaw;
-  auto nElementsPerWorkItem = ClosestPowerOf2(
-      memPerWorkItem / sizeof(T) - /*reserve for other variables*/ 16);
-  assert(nElementsPerWorkItem >= 2);
+  auto config = localConfig
+                    ? *localConfig
+                    : GetBitonicLocalConfig(queue.get_device(), sizeof(T));
+  auto WGSize = config.WGSize;
+  auto nElementsPerWorkItem = config.nElementsPerWorkItem;
   // Corner case when array is smaller than one work item can handle
   if (size < nElementsPerWorkItem)
     nElementsPerWorkItem = 2;
@@ -36,16 +306,13 @@ static void BitonicSortLocal(cl::sycl::queue &queue, std::vector<T> &vec) {
   // Large steps are matched to big boxes of green and blue color
   // Small steps are matched to small boxes of orange color
   // See https://en.wikipedia.org/wiki/Bitonic_sorter#How_the_algorithm_works
-  auto nLargeSteps = log2i(size);
-  auto nOpsPerWorkItem =
-      nElementsPerWorkItem / /*number of arguments of swap operation*/ 2;
-  auto WGSize = ClosestPowerOf2(workGroupSizeRaw);
+  // Padding to the power of two is virtual, see BitonicSortNaive
+  auto nLargeSteps = log2i(NextPowerOf2(size));
   // Corner case when total work items needed
   // is smaller than one work group have
-  WGSize = std::min(WGSize,
-                    static_cast<decltype(WGSize)>(size / nElementsPerWorkItem));
+  WGSize =
+      std::min<size_t>(WGSize, ClosestPowerOf2(size / nElementsPerWorkItem));
   auto WGElements = WGSize * nElementsPerWorkItem;
-  auto nWorkGroups = size / WGElements;
   // Since one work group can handle no more than WGElements it has its own
   // internal large steps limit
   auto nWGLargeSteps = log2i(WGElements);
@@ -53,13 +320,16 @@ static void BitonicSortLocal(cl::sycl::queue &queue, std::vector<T> &vec) {
 #if 0
   std::cout << "size " << size << std::endl;
   std::cout << "nLargeSteps " << nLargeSteps << std::endl;
-  std::cout << "nWorkGroups " << nWorkGroups << std::endl;
   std::cout << "nWGLargeSteps " << nWGLargeSteps << std::endl;
   std::cout << "WGElements " << WGElements << std::endl;
   std::cout << "WGSize " << WGSize << std::endl;
   std::cout << "nElementsPerWorkItem " << nElementsPerWorkItem << std::endl;
 #endif
 
+  auto localEvents = std::vector<event>();
+  auto &events = eventStorage ? *eventStorage : localEvents;
+  events.assign(depEvents.begin(), depEvents.end());
+
   // The algorithm is divided into two parts:
   // "Local" part divides the whole range into chunks of WGElements size
   // and sorts each of them individually with use of local memory
@@ -67,72 +337,39 @@ static void BitonicSortLocal(cl::sycl::queue &queue, std::vector<T> &vec) {
   // it works on larger chuncks which do not fit in local memory
   auto LocalSort = [&](int iLargeStep = 0) {
     assert(iLargeStep == 0 || iLargeStep >= nWGLargeSteps);
-    auto firstLargeStep = iLargeStep == 0 ? 0 : nWGLargeSteps - 1;
-    queue.submit([&](handler &h) {
-      auto global = buf.template get_access<access::mode::read_write>(h);
-      auto local = LocalAccess(range<1>{WGElements}, h);
-      h.parallel_for_work_group<class BitonicSortLocalKernel>(
-          range<1>{nWorkGroups}, range<1>{WGSize}, [=](group<1> g) {
-            auto startIndex = g.get_id(0) * WGElements;
-            // Load items from global memory
-            g.parallel_for_work_item([=](h_item<1> it) {
-              auto localStart = it.get_local_id()[0] * nElementsPerWorkItem;
-              for (auto i = 0; i != nElementsPerWorkItem; ++i) {
-                auto localIndex = localStart + i;
-                local[localIndex] = global[startIndex + localIndex];
-              }
-            });
-
-            // Sort
-            for (auto i = firstLargeStep; i != nWGLargeSteps; ++i) {
-              auto bigBoxSize = (iLargeStep == 0) ? 2 << i : 2 << iLargeStep;
-              for (auto j = 0; j != i + 1; ++j)
-                g.parallel_for_work_item([=](h_item<1> it) {
-                  auto start = it.get_local_id()[0] * nOpsPerWorkItem;
-                  auto boxSize = 2 << (i - j);
-                  for (auto el = 0; el != nOpsPerWorkItem; ++el) {
-                    auto id = start + el;
-                    auto id0 =
-                        ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
-                    auto id1 = id0 + boxSize / 2;
-                    if ((((id0 + startIndex) / bigBoxSize) % 2) ==
-                        (local[id0] < local[id1]))
-                      std::swap(local[id0], local[id1]);
-                  }
-                });
-            }
-
-            // Load items to global memory
-            g.parallel_for_work_item([=](h_item<1> it) {
-              auto localStart = it.get_local_id()[0] * nElementsPerWorkItem;
-              for (auto i = 0; i != nElementsPerWorkItem; ++i) {
-                auto localIndex = localStart + i;
-                global[startIndex + localIndex] = local[localIndex];
-              }
-            });
-          });
-    });
+    if constexpr (Kind == BitonicKernelKind::NDRange)
+      events = {_BitonicLocalStepsND<T>(queue, size, getData, WGSize,
+                                        nElementsPerWorkItem, nWGLargeSteps,
+                                        iLargeStep != 0, events, compare)};
+    else
+      events = {_BitonicLocalStepsHier<T>(queue, size, getData, WGSize,
+                                          nElementsPerWorkItem, nWGLargeSteps,
+                                          iLargeStep != 0, events, compare)};
+    // Label of the first local phase is built only when it is recorded
+    if (iLargeStep != 0)
+      _Record(profile, BitonicPhase::Local, events.front(), iLargeStep,
+              iLargeStep - nWGLargeSteps + 1, iLargeStep);
+    else if (profile)
+      _Record(profile, BitonicPhase::Local, events.front(),
+              "i=0.." + std::to_string(nWGLargeSteps - 1));
   };
   auto GlobalSort = [&](int iLargeStep) {
-    auto lastSmallStep = iLargeStep - log2i(WGElements);
-    auto bigBoxSize = 2 << iLargeStep;
-    for (auto j = 0; j != lastSmallStep + 1; ++j)
-      queue.submit([&](cl::sycl::handler &h) {
-        auto global =
-            buf.template get_access<cl::sycl::access::mode::read_write>(h);
-        // Executing kernel
-        h.parallel_for<class BitonicPartGlobalKernel>(
-            range<1>{size / 2}, [=](cl::sycl::id<1> id_) {
-              auto id = id_[0];
-              auto boxSize = 2 << (iLargeStep - j);
-              auto isSortPhase = static_cast<bool>(j);
-              auto id0 =
-                  ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
-              auto id1 = id0 + boxSize / 2;
-              if (((id0 / bigBoxSize) % 2) == (global[id0] < global[id1]))
-                std::swap(global[id0], global[id1]);
-            });
-      });
+    auto lastSmallStep = static_cast<int>(iLargeStep - log2i(WGElements));
+    // The first small step compares mirrored elements and cannot be fused
+    auto nSeparateSteps = NFusedSteps == 1 ? lastSmallStep + 1 : 1;
+    for (auto j = 0; j != nSeparateSteps; ++j) {
+      events = {_BitonicGlobalStep<T>(queue, size, getData, iLargeStep, j,
+                                      events, compare)};
+      _Record(profile, BitonicPhase::Global, events.front(), iLargeStep, j);
+    }
+    for (auto j = nSeparateSteps; j < lastSmallStep + 1; j += NFusedSteps) {
+      auto nSteps = std::min(NFusedSteps, lastSmallStep + 1 - j);
+      events = {_BitonicFusedGlobalSteps<NFusedSteps, T>(
+          queue, size, getData, size_t{2} << (iLargeStep - j), nSteps, events,
+          compare)};
+      _Record(profile, BitonicPhase::Global, events.front(), iLargeStep, j,
+              j + nSteps - 1);
+    }
   };
 
   LocalSort();
@@ -140,7 +377,97 @@ static void BitonicSortLocal(cl::sycl::queue &queue, std::vector<T> &vec) {
     GlobalSort(i);
     LocalSort(i);
   }
+  return JoinEvents(queue, events);
+}
+
+template <int NFusedSteps, typename T, typename DataGetter,
+          typename Compare = Less>
+static cl::sycl::event
+_BitonicSortLocal(cl::sycl::queue &queue, size_t size, DataGetter getData,
+                  std::vector<cl::sycl::event> const &depEvents,
+                  BitonicProfile *profile = nullptr, Compare compare = {},
+                  BitonicLocalConfig const *localConfig = nullptr,
+                  std::vector<cl::sycl::event> *eventStorage = nullptr) {
+  return _BitonicSortLocalWith<BitonicKernelKind::Hierarchical, NFusedSteps, T>(
+      queue, size, getData, depEvents, profile, compare, localConfig,
+      eventStorage);
+}
+
+// Sorts the buffer without waiting for the result
+template <int NFusedSteps = 1, typename T, typename Compare = Less>
+static void BitonicSortLocal(cl::sycl::queue &queue,
+                             cl::sycl::buffer<T, 1> &buf,
+                             Compare compare = {}) {
+  using namespace cl::sycl;
+  _BitonicSortLocal<NFusedSteps, T>(
+      queue, buf.get_count(),
+      [&buf](handler &h) {
+        return buf.template get_access<access::mode::read_write>(h);
+      },
+      {}, nullptr, compare);
+}
+
+// Sorts size elements of USM memory allocated on the queue's device
+// The result is ready when the returned event completes
+template <int NFusedSteps = 1, typename T, typename Compare = Less>
+static cl::sycl::event
+BitonicSortLocal(cl::sycl::queue &queue, T *data, size_t size,
+                 std::vector<cl::sycl::event> const &depEvents = {},
+                 BitonicProfile *profile = nullptr, Compare compare = {}) {
+  return _BitonicSortLocal<NFusedSteps, T>(
+      queue, size, [data](cl::sycl::handler &) { return data; }, depEvents,
+      profile, compare);
+}
+
+template <int NFusedSteps = 1, typename T, typename Compare = Less>
+static void BitonicSortLocal(cl::sycl::queue &queue, std::vector<T> &vec,
+                             Compare compare = {}) {
+  using namespace cl::sycl;
+  if (vec.size() <= 1)
+    return;
+  auto buf = buffer{vec};
+  BitonicSortLocal<NFusedSteps>(queue, buf, compare);
+  queue.wait();
+  buf.template get_access<access::mode::read_write>();
+}
 
+// Overloads of BitonicSortLocal with the local phase in an nd_range kernel,
+// see _BitonicLocalStepsND
+
+// Sorts the buffer without waiting for the result
+template <int NFusedSteps = 1, typename T, typename Compare = Less>
+static void BitonicSortLocalND(cl::sycl::queue &queue,
+                               cl::sycl::buffer<T, 1> &buf,
+                               Compare compare = {}) {
+  using namespace cl::sycl;
+  _BitonicSortLocalWith<BitonicKernelKind::NDRange, NFusedSteps, T>(
+      queue, buf.get_count(),
+      [&buf](handler &h) {
+        return buf.template get_access<access::mode::read_write>(h);
+      },
+      {}, nullptr, compare, nullptr);
+}
+
+// Sorts size elements of USM memory allocated on the queue's device
+// The result is ready when the returned event completes
+template <int NFusedSteps = 1, typename T, typename Compare = Less>
+static cl::sycl::event
+BitonicSortLocalND(cl::sycl::queue &queue, T *data, size_t size,
+                   std::vector<cl::sycl::event> const &depEvents = {},
+                   BitonicProfile *profile = nullptr, Compare compare = {}) {
+  return _BitonicSortLocalWith<BitonicKernelKind::NDRange, NFusedSteps, T>(
+      queue, size, [data](cl::sycl::handler &) { return data; }, depEvents,
+      profile, compare, nullptr);
+}
+
+template <int NFusedSteps = 1, typename T, typename Compare = Less>
+static void BitonicSortLocalND(cl::sycl::queue &queue, std::vector<T> &vec,
+                               Compare compare = {}) {
+  using namespace cl::sycl;
+  if (vec.size() <= 1)
+    return;
+  auto buf = buffer{vec};
+  BitonicSortLocalND<NFusedSteps>(queue, buf, compare);
   queue.wait();
-  buf.template get_access<cl::sycl::access::mode::read_write>();
+  buf.template get_access<access::mode::read_write>();
 }
@@ -2,43 +2,99 @@
 
 #include <CL/sycl.hpp>
 
+#include <type_traits>
+#include <vector>
+
 #include "../utils.hpp"
+#include "bitonic_profile.hpp"
+
+template <typename T, bool IsUSM, typename Compare, typename Index>
+class BitonicNaiveKernel;
+
+// Kernels of the sort on buffers and USM, see PrebuildKernels
+template <typename T, typename Compare = Less,
+          typename Index = cl::sycl::cl_uint>
+using BitonicSortNaiveKernels =
+    KernelList<BitonicNaiveKernel<T, false, Compare, Index>,
+               BitonicNaiveKernel<T, true, Compare, Index>>;
 
-template <typename T>
-static void BitonicSortNaive(cl::sycl::queue &queue, std::vector<T> &vec) {
+// Submits all kernels of the sort, see _BitonicSortLocal for the parameters
+template <typename T, typename DataGetter, typename Compare = Less>
+static cl::sycl::event
+_BitonicSortNaive(cl::sycl::queue &queue, size_t size, DataGetter getData,
+                  std::vector<cl::sycl::event> const &depEvents,
+                  BitonicProfile *profile = nullptr, Compare compare = {}) {
   using namespace cl::sycl;
-  auto size = vec.size();
-  auto nLargeSteps = static_cast<cl_int>(log2i(size));
-  auto buf = buffer{vec};
-  auto range1d = range<1>{buf.get_count() / 2};
+  auto constexpr isUSM =
+      std::is_pointer_v<std::invoke_result_t<DataGetter, handler &>>;
+  if (size <= 1)
+    return JoinEvents(queue, depEvents);
+  // Array is virtually padded to the power of two with elements going after
+  // any other. Comparators that touch the padding never swap, so they are
+  // simply masked out.
+  auto nLargeSteps = static_cast<cl_int>(log2i(NextPowerOf2(size)));
+  auto events = depEvents;
 
   for (auto i = 0; i != nLargeSteps; ++i)
-    for (auto j = 0; j != i + 1; ++j)
-      queue.submit([&](handler &h) {
-        auto access = buf.template get_access<access::mode::read_write>(h);
-        // Executing kernel
-        h.parallel_for<class BitonicNaiveKernel>(range1d, [access, i,
-                                                           j](id<1> id_) {
-          auto id = id_[0];
-          auto boxSize = 2 << (i - j);
-          auto id0 = ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
-#ifdef ALTERNATIVE
-          // See
-          // https://en.wikipedia.org/wiki/Bitonic_sorter#Alternative_representation
-          auto isSortPhase = static_cast<bool>(j);
-          auto id1 =
-              (id0 + boxSize / 2) +
-              (isSortPhase - 1) * ((2 * (id0 % boxSize)) - boxSize / 2 + 1);
-          if (access[id0] > access[id1])
-            std::swap(access[id0], access[id1]);
-#else  // faster
-          auto id1 = id0 + boxSize / 2;
-          auto bigBoxSize = 2 << i;
-          if (((id0 / bigBoxSize) % 2) == (access[id0] < access[id1]))
-            std::swap(access[id0], access[id1]);
-#endif // ALTERNATIVE
+    for (auto j = 0; j != i + 1; ++j) {
+      auto boxSize = size_t{2} << (i - j);
+      auto range1d = range<1>{BitonicNComparators(size, boxSize)};
+      events = {WithIndexType(size, [&](auto index) {
+        using Index = decltype(index);
+        return queue.submit([&](handler &h) {
+          h.depends_on(events);
+          auto access = getData(h);
+          auto n = static_cast<Index>(size);
+          // Executing kernel
+          h.parallel_for<BitonicNaiveKernel<T, isUSM, Compare, Index>>(
+              range1d, [access, n, i, j, compare](id<1> id_) {
+                auto id = static_cast<Index>(id_[0]);
+                auto boxSize = Index{2} << (i - j);
+                auto id0 =
+                    ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
+                // All comparators sort in the same order, the first small
+                // step of every large step compares mirrored elements
+                // instead. See
+                // https://en.wikipedia.org/wiki/Bitonic_sorter#Alternative_representation
+                auto isSortPhase = static_cast<bool>(j);
+                auto id1 =
+                    isSortPhase ? id0 + boxSize / 2 : id0 ^ (boxSize - 1);
+                if (id1 < n && compare(access[id1], access[id0]))
+                  std::swap(access[id0], access[id1]);
+              });
         });
-      });
+      })};
+      _Record(profile, BitonicPhase::Global, events.front(), i, j);
+    }
+  return JoinEvents(queue, events);
+}
+
+template <typename T, typename Compare = Less>
+static void BitonicSortNaive(cl::sycl::queue &queue, std::vector<T> &vec,
+                             Compare compare = {}) {
+  using namespace cl::sycl;
+  auto size = vec.size();
+  if (size <= 1)
+    return;
+  auto buf = buffer{vec};
+  _BitonicSortNaive<T>(
+      queue, size,
+      [&buf](handler &h) {
+        return buf.template get_access<access::mode::read_write>(h);
+      },
+      {}, nullptr, compare);
   queue.wait();
   buf.template get_access<access::mode::read_write>();
 }
+
+// Sorts size elements of USM memory
+// The result is ready when the returned event completes
+template <typename T, typename Compare = Less>
+static cl::sycl::event
+BitonicSortNaive(cl::sycl::queue &queue, T *data, size_t size,
+                 std::vector<cl::sycl::event> const &depEvents = {},
+                 BitonicProfile *profile = nullptr, Compare compare = {}) {
+  return _BitonicSortNaive<T>(
+      queue, size, [data](cl::sycl::handler &) { return data; }, depEvents,
+      profile, compare);
+}
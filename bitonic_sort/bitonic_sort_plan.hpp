@@ -0,0 +1,86 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../utils.hpp"
+#include "bitonic_local_config.hpp"
+#include "bitonic_sort_local.hpp"
+
+// BitonicSortLocal<NFusedSteps> of arrays of up to maxSize elements on queue
+// The device is queried and the configuration is computed once, and the
+// device memory the host arrays are copied to is allocated once, so repeated
+// sorts of same-shaped batches only submit the copies and the kernels. Lists
+// of events the kernels are chained through are kept by the plan as well, so
+// a sort does no host allocation of its own. A plan is used by one thread at
+// a time.
+template <typename T, typename Compare = Less, int NFusedSteps = 1>
+class SortPlan {
+public:
+  SortPlan(cl::sycl::queue const &queue, size_t maxSize, Compare compare = {})
+      : queue(queue), maxSize(maxSize), compare(compare),
+        config(GetBitonicLocalConfig(queue.get_device(), sizeof(T))),
+        scratch(cl::sycl::malloc_device<T>(maxSize, queue)) {
+    copiedEvents.reserve(1);
+    events.reserve(1);
+  }
+
+  ~SortPlan() { cl::sycl::free(scratch, queue); }
+
+  SortPlan(SortPlan const &) = delete;
+  SortPlan &operator=(SortPlan const &) = delete;
+
+  size_t MaxSize() const { return maxSize; }
+  BitonicLocalConfig const &Config() const { return config; }
+
+  // Sorts size elements of USM memory allocated on the queue's device, of
+  // any size since the scratch memory is not used
+  // The result is ready when the returned event completes
+  cl::sycl::event Sort(T *data, size_t size,
+                       std::vector<cl::sycl::event> const &depEvents = {},
+                       BitonicProfile *profile = nullptr) {
+    return _BitonicSortLocal<NFusedSteps, T>(
+        queue, size, [data](cl::sycl::handler &) { return data; }, depEvents,
+        profile, compare, &config, &events);
+  }
+
+  // Sorts the vector through the device memory of the plan
+  void Sort(std::vector<T> &vec) {
+    using namespace cl::sycl;
+    auto size = vec.size();
+    _CheckSize(size);
+    if (size <= 1)
+      return;
+    auto copied = queue.submit(
+        [&](handler &h) { h.memcpy(scratch, vec.data(), size * sizeof(T)); });
+    copiedEvents.assign(1, copied);
+    auto sorted = Sort(scratch, size, copiedEvents);
+    queue
+        .submit([&](handler &h) {
+          h.depends_on(sorted);
+          h.memcpy(vec.data(), scratch, size * sizeof(T));
+        })
+        .wait();
+  }
+
+private:
+  // Larger arrays would overrun the scratch memory, so they fail even in
+  // release builds. Only arrays copied through it are checked.
+  void _CheckSize(size_t size) const {
+    if (size > maxSize)
+      throw std::runtime_error{"SortPlan of " + std::to_string(maxSize) +
+                               " elements cannot sort " +
+                               std::to_string(size)};
+  }
+
+  cl::sycl::queue queue;
+  size_t maxSize;
+  Compare compare;
+  BitonicLocalConfig config;
+  T *scratch;
+  std::vector<cl::sycl::event> copiedEvents;
+  std::vector<cl::sycl::event> events;
+};
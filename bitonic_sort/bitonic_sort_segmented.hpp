@@ -0,0 +1,131 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "../utils.hpp"
+#include "bitonic_sort_local.hpp"
+
+template <typename T, typename Compare> class BitonicSegmentedKernel;
+
+// Kernels of BitonicSortSegmented, see PrebuildKernels
+template <typename T, typename Compare = Less>
+using BitonicSortSegmentedKernels =
+    KernelList<BitonicSegmentedKernel<T, Compare>>;
+
+// Sorts every segment [offsets[i], offsets[i + 1]) of the array independently
+// Segments that fit into local memory are sorted by one kernel with a work
+// group per segment, larger ones are sorted by BitonicSortLocal concurrently.
+// Device memory comes from pool if given.
+template <typename T, typename Compare = Less>
+static void BitonicSortSegmented(cl::sycl::queue &queue, std::vector<T> &vec,
+                                 std::vector<size_t> const &offsets,
+                                 Compare compare = {},
+                                 UsmPool *pool = nullptr) {
+  using namespace cl::sycl;
+  using LocalAccess =
+      accessor<T, 1, access::mode::read_write, access::target::local>;
+  auto size = vec.size();
+  if (size <= 1 || offsets.size() <= 1)
+    return;
+  assert(offsets.back() <= size);
+
+  // Same local memory limit as in BitonicSortLocal
+  auto config = GetBitonicLocalConfig(queue.get_device(), sizeof(T));
+  auto maxWGSize = config.WGSize;
+  auto maxWGElements = maxWGSize * config.nElementsPerWorkItem;
+
+  // Start and size of each small segment
+  auto smallSegments = std::vector<size_t>();
+  auto largeSegments = std::vector<size_t>();
+  auto maxSmallSegment = size_t{2};
+  for (auto i = size_t{0}; i + 1 < offsets.size(); ++i) {
+    auto segmentSize = offsets[i + 1] - offsets[i];
+    if (segmentSize <= 1)
+      continue;
+    if (segmentSize > maxWGElements) {
+      largeSegments.push_back(i);
+      continue;
+    }
+    smallSegments.push_back(offsets[i]);
+    smallSegments.push_back(segmentSize);
+    maxSmallSegment = std::max(maxSmallSegment, segmentSize);
+  }
+  auto nSmallSegments = smallSegments.size() / 2;
+
+  // Work group is as large as the largest small segment needs
+  auto WGElements = size_t{NextPowerOf2(maxSmallSegment)};
+  auto WGSize = std::min(maxWGSize, WGElements / 2);
+  auto nElementsPerWorkItem = WGElements / WGSize;
+  auto nOpsPerWorkItem = nElementsPerWorkItem / 2;
+
+  auto *data = UsmAllocate<T>(queue, pool, size);
+  auto copied = queue.submit(
+      [&](handler &h) { h.memcpy(data, vec.data(), size * sizeof(T)); });
+  auto events = std::vector<event>();
+  // Large segments are submitted first since buffer destruction below waits
+  // for the small ones
+  for (auto segment : largeSegments)
+    events.push_back(BitonicSortLocal(queue, data + offsets[segment],
+                                      offsets[segment + 1] - offsets[segment],
+                                      {copied}, nullptr, compare));
+  if (nSmallSegments != 0) {
+    auto segmentsBuf = buffer{smallSegments};
+    events.push_back(queue.submit([&](handler &h) {
+      h.depends_on(copied);
+      auto segments = segmentsBuf.template get_access<access::mode::read>(h);
+      auto local = LocalAccess(range<1>{WGElements}, h);
+      h.parallel_for_work_group<BitonicSegmentedKernel<T, Compare>>(
+          range<1>{nSmallSegments}, range<1>{WGSize}, [=](group<1> g) {
+            auto startIndex = segments[2 * g.get_id(0)];
+            auto nElements = segments[2 * g.get_id(0) + 1];
+            auto nLargeSteps = log2i(NextPowerOf2(nElements));
+            g.parallel_for_work_item([=](h_item<1> it) {
+              auto localStart = it.get_local_id()[0] * nElementsPerWorkItem;
+              for (auto i = size_t{0}; i != nElementsPerWorkItem; ++i) {
+                auto localIndex = localStart + i;
+                if (localIndex < nElements)
+                  local[localIndex] = data[startIndex + localIndex];
+              }
+            });
+
+            for (auto i = 0; i != nLargeSteps; ++i)
+              for (auto j = 0; j != i + 1; ++j)
+                g.parallel_for_work_item([=](h_item<1> it) {
+                  auto start = it.get_local_id()[0] * nOpsPerWorkItem;
+                  auto boxSize = size_t{2} << (i - j);
+                  auto isSortPhase = static_cast<bool>(j);
+                  for (auto el = size_t{0}; el != nOpsPerWorkItem; ++el) {
+                    auto id = start + el;
+                    auto id0 =
+                        ((id / (boxSize / 2)) * boxSize) + (id % (boxSize / 2));
+                    auto id1 =
+                        isSortPhase ? id0 + boxSize / 2 : id0 ^ (boxSize - 1);
+                    if (id1 < nElements && compare(local[id1], local[id0]))
+                      std::swap(local[id0], local[id1]);
+                  }
+                });
+
+            g.parallel_for_work_item([=](h_item<1> it) {
+              auto localStart = it.get_local_id()[0] * nElementsPerWorkItem;
+              for (auto i = size_t{0}; i != nElementsPerWorkItem; ++i) {
+                auto localIndex = localStart + i;
+                if (localIndex < nElements)
+                  data[startIndex + localIndex] = local[localIndex];
+              }
+            });
+          });
+    }));
+  }
+
+  queue
+      .submit([&](handler &h) {
+        h.depends_on(events);
+        h.depends_on(copied);
+        h.memcpy(vec.data(), data, size * sizeof(T));
+      })
+      .wait();
+  UsmFree(queue, pool, data);
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITONIC_X86 1
+#endif
+
+#include "../merge_sort/thread_pool.hpp"
+#include "../utils.hpp"
+
+// Host bitonic sort of 32-bit integers with x86 SIMD
+// The network is the one of BitonicSortNaive. Comparators of a step with
+// boxes larger than a register compare whole registers with min/max, the
+// first small step reversing one of them by a shuffle. Steps within a
+// register are done together by shuffles and blends once it is loaded.
+// Array is sorted in blocks fitting into L2 cache first, so only large steps
+// spanning several blocks go through memory. Blocks and comparators of steps
+// spanning several blocks are split between the threads of the pool.
+
+enum class HostISA { Scalar, AVX2, AVX512 };
+
+static std::string ToString(HostISA isa) {
+  switch (isa) {
+  case HostISA::Scalar:
+    return "scalar";
+  case HostISA::AVX2:
+    return "AVX2";
+  case HostISA::AVX512:
+    return "AVX-512";
+  }
+  return {};
+}
+
+// The widest instruction set the host supports
+static HostISA GetHostISA() {
+#ifdef BITONIC_X86
+  if (__builtin_cpu_supports("avx512f"))
+    return HostISA::AVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return HostISA::AVX2;
+#endif
+  return HostISA::Scalar;
+}
+
+// Comparators [cFirst, cLast) of the step with boxes of boxSize elements
+// isFirst is the first small step comparing an element with the mirrored one
+struct BitonicScalar {
+  static size_t constexpr N = 8;
+
+  static void Step(cl::sycl::cl_int *data, size_t boxSize, bool isFirst,
+                   size_t cFirst, size_t cLast) {
+    auto half = boxSize / 2;
+    for (auto c = cFirst; c != cLast; ++c) {
+      auto boxStart = c / half * boxSize;
+      auto k = c % half;
+      auto id0 = boxStart + k;
+      auto id1 = isFirst ? boxStart + boxSize - 1 - k : id0 + half;
+      if (data[id1] < data[id0])
+        std::swap(data[id0], data[id1]);
+    }
+  }
+
+  // Steps from boxSize down to 2 of elements [first, last), boxSize <= N
+  static void Merge(cl::sycl::cl_int *data, size_t first, size_t last,
+                    size_t boxSize, bool isFirst) {
+    for (; boxSize >= 2; boxSize /= 2, isFirst = false)
+      Step(data, boxSize, isFirst, first / 2, last / 2);
+  }
+};
+
+#ifdef BITONIC_X86
+struct BitonicAVX2 {
+  static size_t constexpr N = 8;
+
+  __attribute__((target("avx2"))) static void
+  Step(cl::sycl::cl_int *data, size_t boxSize, bool isFirst, size_t cFirst,
+       size_t cLast) {
+    auto half = boxSize / 2;
+    auto reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    for (auto c = cFirst; c < cLast; c += N) {
+      auto *p0 = data + c / half * boxSize + c % half;
+      auto *p1 = isFirst ? p0 + boxSize - 2 * (c % half) - N : p0 + half;
+      auto v0 = _mm256_loadu_si256(reinterpret_cast<__m256i *>(p0));
+      auto v1 = _mm256_loadu_si256(reinterpret_cast<__m256i *>(p1));
+      if (isFirst)
+        v1 = _mm256_permutevar8x32_epi32(v1, reverse);
+      auto lo = _mm256_min_epi32(v0, v1);
+      auto hi = _mm256_max_epi32(v0, v1);
+      if (isFirst)
+        hi = _mm256_permutevar8x32_epi32(hi, reverse);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(p0), lo);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(p1), hi);
+    }
+  }
+
+  __attribute__((target("avx2"))) static void
+  Merge(cl::sycl::cl_int *data, size_t first, size_t last, size_t boxSize,
+        bool isFirst) {
+    // Partner of every lane and lanes taking the maximum for each step
+    auto lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i partners[3], takeMax[3];
+    auto nSteps = 0;
+    for (; boxSize >= 2; boxSize /= 2, isFirst = false, ++nSteps) {
+      auto distance = static_cast<int>(isFirst ? boxSize - 1 : boxSize / 2);
+      partners[nSteps] = _mm256_xor_si256(lanes, _mm256_set1_epi32(distance));
+      takeMax[nSteps] = _mm256_cmpgt_epi32(
+          _mm256_and_si256(lanes, _mm256_set1_epi32(boxSize / 2)),
+          _mm256_setzero_si256());
+    }
+    for (auto i = first; i < last; i += N) {
+      auto *p = reinterpret_cast<__m256i *>(data + i);
+      auto v = _mm256_loadu_si256(p);
+      for (auto step = 0; step != nSteps; ++step) {
+        auto partner = _mm256_permutevar8x32_epi32(v, partners[step]);
+        v = _mm256_blendv_epi8(_mm256_min_epi32(v, partner),
+                               _mm256_max_epi32(v, partner), takeMax[step]);
+      }
+      _mm256_storeu_si256(p, v);
+    }
+  }
+};
+
+struct BitonicAVX512 {
+  static size_t constexpr N = 16;
+
+  __attribute__((target("avx512f"))) static void
+  Step(cl::sycl::cl_int *data, size_t boxSize, bool isFirst, size_t cFirst,
+       size_t cLast) {
+    auto half = boxSize / 2;
+    auto reverse = _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4,
+                                     3, 2, 1, 0);
+    for (auto c = cFirst; c < cLast; c += N) {
+      auto *p0 = data + c / half * boxSize + c % half;
+      auto *p1 = isFirst ? p0 + boxSize - 2 * (c % half) - N : p0 + half;
+      auto v0 = _mm512_loadu_si512(p0);
+      auto v1 = _mm512_loadu_si512(p1);
+      if (isFirst)
+        v1 = _mm512_permutexvar_epi32(reverse, v1);
+      auto lo = _mm512_min_epi32(v0, v1);
+      auto hi = _mm512_max_epi32(v0, v1);
+      if (isFirst)
+        hi = _mm512_permutexvar_epi32(reverse, hi);
+      _mm512_storeu_si512(p0, lo);
+      _mm512_storeu_si512(p1, hi);
+    }
+  }
+
+  __attribute__((target("avx512f"))) static void
+  Merge(cl::sycl::cl_int *data, size_t first, size_t last, size_t boxSize,
+        bool isFirst) {
+    auto lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                                   13, 14, 15);
+    __m512i partners[4];
+    __mmask16 takeMax[4];
+    auto nSteps = 0;
+    for (; boxSize >= 2; boxSize /= 2, isFirst = false, ++nSteps) {
+      auto distance = static_cast<int>(isFirst ? boxSize - 1 : boxSize / 2);
+      partners[nSteps] = _mm512_xor_si512(lanes, _mm512_set1_epi32(distance));
+      takeMax[nSteps] =
+          _mm512_test_epi32_mask(lanes, _mm512_set1_epi32(boxSize / 2));
+    }
+    for (auto i = first; i < last; i += N) {
+      auto v = _mm512_loadu_si512(data + i);
+      for (auto step = 0; step != nSteps; ++step) {
+        auto partner = _mm512_permutexvar_epi32(partners[step], v);
+        v = _mm512_mask_blend_epi32(takeMax[step],
+                                    _mm512_min_epi32(v, partner),
+                                    _mm512_max_epi32(v, partner));
+      }
+      _mm512_storeu_si512(data + i, v);
+    }
+  }
+};
+#endif
+
+// Small steps from firstJ to the last one of large step i on a block of
+// blockSize elements
+template <typename Ops>
+static void _BitonicBlockSteps(cl::sycl::cl_int *block, size_t blockSize,
+                               int i, int firstJ) {
+  for (auto j = firstJ; j != i + 1; ++j) {
+    auto boxSize = size_t{2} << (i - j);
+    if (boxSize <= Ops::N) {
+      Ops::Merge(block, 0, blockSize, boxSize, j == 0);
+      return;
+    }
+    Ops::Step(block, boxSize, j == 0, 0, blockSize / 2);
+  }
+}
+
+template <typename Ops>
+static void _BitonicSortSIMD(ThreadPool &pool, cl::sycl::cl_int *data,
+                             size_t size) {
+  // 64 KB blocks
+  auto constexpr maxBlockSize = size_t{1} << 14;
+  auto blockSize = std::min(size, maxBlockSize);
+  auto nBlocks = size / blockSize;
+  auto nBlockLargeSteps = static_cast<int>(log2i(blockSize));
+  pool.ParallelFor(nBlocks, [&](size_t block) {
+    for (auto i = 0; i != nBlockLargeSteps; ++i)
+      _BitonicBlockSteps<Ops>(data + block * blockSize, blockSize, i, 0);
+  });
+
+  auto nLargeSteps = static_cast<int>(log2i(size));
+  for (auto i = nBlockLargeSteps; i != nLargeSteps; ++i)
+    for (auto j = 0; j != i + 1; ++j) {
+      auto boxSize = size_t{2} << (i - j);
+      if (boxSize <= blockSize) {
+        pool.ParallelFor(nBlocks, [&](size_t block) {
+          _BitonicBlockSteps<Ops>(data + block * blockSize, blockSize, i, j);
+        });
+        break;
+      }
+      // A block worth of comparators per task
+      pool.ParallelFor(nBlocks, [&](size_t block) {
+        Ops::Step(data, boxSize, j == 0, block * blockSize / 2,
+                  (block + 1) * blockSize / 2);
+      });
+    }
+}
+
+// Array is padded to a power of two with the largest values, isa is limited
+// to the instruction sets the host supports
+static void BitonicSortSIMD(ThreadPool &pool,
+                            std::vector<cl::sycl::cl_int> &vec,
+                            HostISA isa = GetHostISA()) {
+  using namespace cl::sycl;
+  auto size = vec.size();
+  if (size <= 1)
+    return;
+  auto paddedSize = std::max<size_t>(NextPowerOf2(size), 16);
+  auto padded = std::vector<cl_int>(paddedSize);
+  std::copy(vec.begin(), vec.end(), padded.begin());
+  std::fill(padded.begin() + size, padded.end(),
+            std::numeric_limits<cl_int>::max());
+
+  isa = std::min(isa, GetHostISA());
+  switch (isa) {
+#ifdef BITONIC_X86
+  case HostISA::AVX512:
+    _BitonicSortSIMD<BitonicAVX512>(pool, padded.data(), paddedSize);
+    break;
+  case HostISA::AVX2:
+    _BitonicSortSIMD<BitonicAVX2>(pool, padded.data(), paddedSize);
+    break;
+#endif
+  default:
+    _BitonicSortSIMD<BitonicScalar>(pool, padded.data(), paddedSize);
+  }
+  std::copy(padded.begin(), padded.begin() + size, vec.begin());
+}
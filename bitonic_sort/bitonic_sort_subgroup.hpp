@@ -0,0 +1,209 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "../utils.hpp"
+#include "bitonic_local_config.hpp"
+#include "bitonic_profile.hpp"
+#include "bitonic_sort_local.hpp"
+
+template <typename T, bool IsUSM, typename Compare, int NElements>
+class BitonicSubGroupLocalKernel;
+
+// Kernels of BitonicSortSubGroup<NElements> on buffers and USM, the global
+// steps are the ones of BitonicSortLocal, see PrebuildKernels
+template <typename T, typename Compare = Less, int NElements = 8,
+          typename Index = cl::sycl::cl_uint>
+using BitonicSortSubGroupKernels =
+    KernelList<BitonicSubGroupLocalKernel<T, false, Compare, NElements>,
+               BitonicSubGroupLocalKernel<T, true, Compare, NElements>,
+               BitonicPartGlobalKernel<T, false, Compare, Index>,
+               BitonicPartGlobalKernel<T, true, Compare, Index>>;
+
+// Local phase of the sort keeping NElements elements of every work item in
+// registers. Element e of lane l of a sub-group of S work items is at
+// position e * S + l of the sub-group's S * NElements elements of the tile,
+// so partners of steps with half boxes below S are in the same register of
+// another lane and are exchanged with a shuffle, and partners of half boxes
+// up to S * NElements are in another register of the same work item.
+// Only larger boxes go through local memory with a barrier per step.
+// All large steps of the tile are done, or only the small steps of the last
+// one in the continuation of the global phase.
+template <int NElements, typename T, typename DataGetter, typename Compare>
+static cl::sycl::event
+_BitonicSubGroupLocalSteps(cl::sycl::queue &queue, size_t size,
+                           DataGetter getData, size_t WGSize,
+                           bool isContinuation,
+                           std::vector<cl::sycl::event> const &depEvents,
+                           Compare compare) {
+  using namespace cl::sycl;
+  using LocalAccess =
+      accessor<T, 1, access::mode::read_write, access::target::local>;
+  auto constexpr isUSM =
+      std::is_pointer_v<std::invoke_result_t<DataGetter, handler &>>;
+  auto WGElements = WGSize * NElements;
+  auto nWorkGroups = (size + WGElements - 1) / WGElements;
+  auto nWGLargeSteps = static_cast<int>(log2i(WGElements));
+  auto firstLargeStep = isContinuation ? nWGLargeSteps - 1 : 0;
+  return queue.submit([&](handler &h) {
+    h.depends_on(depEvents);
+    auto global = getData(h);
+    auto local = LocalAccess(range<1>{WGElements}, h);
+    h.parallel_for<BitonicSubGroupLocalKernel<T, isUSM, Compare, NElements>>(
+        nd_range<1>{range<1>{nWorkGroups * WGSize}, range<1>{WGSize}},
+        [=](nd_item<1> it) {
+          auto sg = it.get_sub_group();
+          auto S = sg.get_local_range()[0];
+          auto lane = sg.get_local_id()[0];
+          auto startIndex = it.get_group_linear_id() * WGElements;
+          auto nElements = std::min<size_t>(WGElements, size - startIndex);
+          auto localId = it.get_local_id(0);
+          auto sgStart = (localId - lane) * NElements;
+          auto Position = [=](int e) { return sgStart + e * S + lane; };
+
+          // Elements past the end of the array are never compared
+          T registers[NElements];
+          for (auto e = 0; e != NElements; ++e)
+            if (Position(e) < nElements)
+              registers[e] = global[startIndex + Position(e)];
+
+          for (auto i = firstLargeStep; i != nWGLargeSteps; ++i) {
+            auto j = 0;
+            // Boxes spanning several sub-groups
+            if ((size_t{2} << i) > S * NElements) {
+              for (auto e = 0; e != NElements; ++e)
+                local[Position(e)] = registers[e];
+              for (; (size_t{1} << (i - j)) >= S * NElements; ++j) {
+                it.barrier(access::fence_space::local_space);
+                auto boxSize = size_t{2} << (i - j);
+                auto isSortPhase = isContinuation || j != 0;
+                for (auto c = localId; c < WGElements / 2; c += WGSize) {
+                  auto id0 = (c / (boxSize / 2)) * boxSize + c % (boxSize / 2);
+                  auto id1 =
+                      isSortPhase ? id0 + boxSize / 2 : id0 ^ (boxSize - 1);
+                  if (id1 < nElements && compare(local[id1], local[id0]))
+                    std::swap(local[id0], local[id1]);
+                }
+              }
+              it.barrier(access::fence_space::local_space);
+              for (auto e = 0; e != NElements; ++e)
+                registers[e] = local[Position(e)];
+              // Local memory is reused by the next large step
+              it.barrier(access::fence_space::local_space);
+            }
+
+            for (; j != i + 1; ++j) {
+              auto boxSize = size_t{2} << (i - j);
+              auto halfBoxSize = boxSize / 2;
+              auto isSortPhase = isContinuation || j != 0;
+              auto mask = isSortPhase ? halfBoxSize : boxSize - 1;
+              T partners[NElements];
+              if (halfBoxSize < S) {
+                for (auto e = 0; e != NElements; ++e)
+                  partners[e] = sg.shuffle_xor(registers[e], id<1>{mask});
+              } else if (isSortPhase) {
+                for (auto e = 0; e != NElements; ++e)
+                  partners[e] = registers[e ^ (halfBoxSize / S)];
+              } else {
+                // Mirrored element is in another register of another lane
+                for (auto e = 0; e != NElements; ++e)
+                  partners[e] = sg.shuffle_xor(
+                      registers[e ^ (boxSize / S - 1)], id<1>{S - 1});
+              }
+              for (auto e = 0; e != NElements; ++e) {
+                auto position = Position(e);
+                auto isFirst = (position & halfBoxSize) == 0;
+                if (std::max(position, position ^ mask) >= nElements)
+                  continue;
+                auto &value = registers[e];
+                if (isFirst ? compare(partners[e], value)
+                            : compare(value, partners[e]))
+                  value = partners[e];
+              }
+            }
+          }
+
+          for (auto e = 0; e != NElements; ++e)
+            if (Position(e) < nElements)
+              global[startIndex + Position(e)] = registers[e];
+        });
+  });
+}
+
+// Sort of BitonicSortLocal with the local phase of
+// _BitonicSubGroupLocalSteps, see _BitonicSortLocal for the parameters
+// Work groups keep the tile size of the local memory configuration.
+template <int NElements, typename T, typename DataGetter,
+          typename Compare = Less>
+static cl::sycl::event
+_BitonicSortSubGroup(cl::sycl::queue &queue, size_t size, DataGetter getData,
+                     std::vector<cl::sycl::event> const &depEvents,
+                     BitonicProfile *profile = nullptr, Compare compare = {}) {
+  static_assert(NElements >= 2 && (NElements & (NElements - 1)) == 0);
+  using namespace cl::sycl;
+  if (size <= 1)
+    return JoinEvents(queue, depEvents);
+
+  auto device = queue.get_device();
+  auto config = GetBitonicLocalConfig(device, sizeof(T));
+  auto maxWGSize =
+      ClosestPowerOf2(device.get_info<info::device::max_work_group_size>());
+  auto WGSize = std::clamp<size_t>(
+      config.WGSize * config.nElementsPerWorkItem / NElements, 1, maxWGSize);
+  WGSize = std::min(WGSize, NextPowerOf2((size + NElements - 1) / NElements));
+  auto WGElements = WGSize * NElements;
+  auto nWGLargeSteps = static_cast<int>(log2i(WGElements));
+  // Padding to the power of two is virtual, see BitonicSortNaive
+  auto nLargeSteps = static_cast<int>(log2i(NextPowerOf2(size)));
+
+  auto events = std::vector<event>{_BitonicSubGroupLocalSteps<NElements, T>(
+      queue, size, getData, WGSize, false, depEvents, compare)};
+  if (profile)
+    _Record(profile, BitonicPhase::Local, events.front(),
+            "i=0.." + std::to_string(nWGLargeSteps - 1));
+  for (auto i = nWGLargeSteps; i < nLargeSteps; ++i) {
+    for (auto j = 0; j != i - nWGLargeSteps + 1; ++j) {
+      events = {_BitonicGlobalStep<T>(queue, size, getData, i, j, events,
+                                      compare)};
+      _Record(profile, BitonicPhase::Global, events.front(), i, j);
+    }
+    events = {_BitonicSubGroupLocalSteps<NElements, T>(
+        queue, size, getData, WGSize, true, events, compare)};
+    _Record(profile, BitonicPhase::Local, events.front(), i,
+            i - nWGLargeSteps + 1, i);
+  }
+  return JoinEvents(queue, events);
+}
+
+template <int NElements = 8, typename T, typename Compare = Less>
+static void BitonicSortSubGroup(cl::sycl::queue &queue, std::vector<T> &vec,
+                                Compare compare = {}) {
+  using namespace cl::sycl;
+  if (vec.size() <= 1)
+    return;
+  auto buf = buffer{vec};
+  _BitonicSortSubGroup<NElements, T>(
+      queue, vec.size(),
+      [&buf](handler &h) {
+        return buf.template get_access<access::mode::read_write>(h);
+      },
+      {}, nullptr, compare);
+  queue.wait();
+  buf.template get_access<access::mode::read_write>();
+}
+
+// Sorts size elements of USM memory
+// The result is ready when the returned event completes
+template <int NElements = 8, typename T, typename Compare = Less>
+static cl::sycl::event
+BitonicSortSubGroup(cl::sycl::queue &queue, T *data, size_t size,
+                    std::vector<cl::sycl::event> const &depEvents = {},
+                    BitonicProfile *profile = nullptr, Compare compare = {}) {
+  return _BitonicSortSubGroup<NElements, T>(
+      queue, size, [data](cl::sycl::handler &) { return data; }, depEvents,
+      profile, compare);
+}
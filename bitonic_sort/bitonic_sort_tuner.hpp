@@ -0,0 +1,71 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+#include "../utils.hpp"
+#include "bitonic_local_config.hpp"
+#include "bitonic_sort_local.hpp"
+
+// Times BitonicSortLocal on size random elements with every work group size
+// and number of elements per work item that fit into local memory, which also
+// sweeps the split between the local and global phases. The fastest
+// configuration goes to the tuning cache on disk, so later sorts of the same
+// element size on the device use it.
+template <typename T>
+static BitonicLocalConfig TuneBitonicSortLocal(cl::sycl::queue &queue,
+                                               size_t size,
+                                               size_t nRepeats = 3,
+                                               std::ostream *log = nullptr) {
+  using namespace cl::sycl;
+  using std::chrono::nanoseconds;
+  auto device = queue.get_device();
+  auto maxWGSize =
+      ClosestPowerOf2(device.get_info<info::device::max_work_group_size>());
+  auto localMem = device.get_info<info::device::local_mem_size>();
+  auto vec = GetRandomVector<T>(size);
+  auto *data = malloc_device<T>(size, queue);
+
+  auto best = GetBitonicLocalConfig(device, sizeof(T));
+  auto bestTime = nanoseconds::max();
+  for (auto WGSize = size_t{1}; WGSize <= maxWGSize; WGSize *= 2)
+    for (auto nElementsPerWorkItem = size_t{2};
+         WGSize * nElementsPerWorkItem * sizeof(T) <= localMem &&
+         WGSize * nElementsPerWorkItem <= NextPowerOf2(size);
+         nElementsPerWorkItem *= 2) {
+      auto config = BitonicLocalConfig{WGSize, nElementsPerWorkItem};
+      auto times = std::vector<nanoseconds>();
+      for (auto i = size_t{0}; i != nRepeats; ++i) {
+        queue
+            .submit([&](handler &h) {
+              h.memcpy(data, vec.data(), size * sizeof(T));
+            })
+            .wait();
+        times.push_back(std::chrono::duration_cast<nanoseconds>(
+            Utility::Benchmark([&]() {
+              _BitonicSortLocal<1, T>(
+                  queue, size, [data](handler &) { return data; }, {},
+                  nullptr, Less{}, &config)
+                  .wait();
+            })));
+      }
+      auto time = GetStats(std::move(times), size).median;
+      if (log)
+        *log << "  work group of " << WGSize << ", " << nElementsPerWorkItem
+             << " elements per work item, "
+             << log2i(WGSize * nElementsPerWorkItem) << " local large steps: "
+             << (time.count() / 1000) << " microseconds" << std::endl;
+      if (time < bestTime) {
+        bestTime = time;
+        best = config;
+      }
+    }
+  free(data, queue);
+
+  _BitonicTuningCache()[_BitonicTuningKey(device, sizeof(T))] = best;
+  SaveBitonicTuningCache(_BitonicTuningCache(), GetBitonicTuningCachePath());
+  return best;
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "../utils.hpp"
+#include "bitonic_local_config.hpp"
+#include "bitonic_sort_local.hpp"
+
+template <typename T, typename Compare> class BitonicTopKKernel;
+
+// Kernels of BitonicTopK, see PrebuildKernels
+template <typename T, typename Compare = Less>
+using BitonicTopKKernels = KernelList<BitonicTopKKernel<T, Compare>>;
+
+// Value going after all others, it pads incomplete tiles
+template <typename T, typename Compare> static T _BitonicTopKPadding() {
+  static_assert(std::is_arithmetic_v<T>);
+  static_assert(std::is_same_v<Compare, Less> ||
+                    std::is_same_v<Compare, Greater>,
+                "Top k supports Less and Greater only");
+  using limits = std::numeric_limits<T>;
+  if constexpr (std::is_same_v<Compare, Less>)
+    return limits::has_infinity ? limits::infinity() : limits::max();
+  else
+    return limits::has_infinity ? -limits::infinity() : limits::lowest();
+}
+
+// One pass of the top k: every work group loads a tile of WGElements
+// elements to local memory, sorts its runs of K elements and merges the runs
+// pairwise keeping the first K elements of each pair, until one run is left.
+// The run goes to output[K * group], so a pass reduces size elements to
+// K * nWorkGroups sorted runs.
+// Merge of two sorted runs keeps the better one of A[t] and B[K - 1 - t],
+// which is a bitonic sequence of the first K elements of the pair, and sorts
+// it with log2(K) small steps.
+template <typename T, typename Compare>
+static cl::sycl::event
+_BitonicTopKPass(cl::sycl::queue &queue, T const *input, size_t size,
+                 T *output, size_t K, size_t WGSize, size_t WGElements,
+                 std::vector<cl::sycl::event> const &depEvents,
+                 Compare compare) {
+  using namespace cl::sycl;
+  using LocalAccess =
+      accessor<T, 1, access::mode::read_write, access::target::local>;
+  auto nWorkGroups = (size + WGElements - 1) / WGElements;
+  auto nElementsPerWorkItem = WGElements / WGSize;
+  auto nRunLargeSteps = static_cast<int>(log2i(K));
+  auto padding = _BitonicTopKPadding<T, Compare>();
+  return queue.submit([&](handler &h) {
+    h.depends_on(depEvents);
+    auto local = LocalAccess(range<1>{WGElements}, h);
+    h.parallel_for_work_group<BitonicTopKKernel<T, Compare>>(
+        range<1>{nWorkGroups}, range<1>{WGSize}, [=](group<1> g) {
+          auto startIndex = g.get_id(0) * WGElements;
+          auto nElements = std::min<size_t>(WGElements, size - startIndex);
+          g.parallel_for_work_item([=](h_item<1> it) {
+            auto localStart = it.get_local_id()[0] * nElementsPerWorkItem;
+            for (auto i = size_t{0}; i != nElementsPerWorkItem; ++i) {
+              auto localIndex = localStart + i;
+              local[localIndex] = localIndex < nElements
+                                      ? input[startIndex + localIndex]
+                                      : padding;
+            }
+          });
+
+          // Sort runs of K elements
+          for (auto i = 0; i != nRunLargeSteps; ++i)
+            for (auto j = 0; j != i + 1; ++j)
+              g.parallel_for_work_item([=](h_item<1> it) {
+                auto boxSize = size_t{2} << (i - j);
+                auto halfBoxSize = boxSize / 2;
+                for (auto id = it.get_local_id()[0]; id < WGElements / 2;
+                     id += WGSize) {
+                  auto id0 = id / halfBoxSize * boxSize + id % halfBoxSize;
+                  auto id1 = j != 0 ? id0 + halfBoxSize : id0 ^ (boxSize - 1);
+                  if (compare(local[id1], local[id0]))
+                    std::swap(local[id0], local[id1]);
+                }
+              });
+
+          // Runs left after every merge are stride runs apart
+          for (auto stride = size_t{1}; stride * K < WGElements; stride *= 2) {
+            auto nPairs = WGElements / K / stride / 2;
+            g.parallel_for_work_item([=](h_item<1> it) {
+              for (auto id = it.get_local_id()[0]; id < nPairs * K;
+                   id += WGSize) {
+                auto first = id / K * 2 * stride * K;
+                auto t = id % K;
+                auto &a = local[first + t];
+                auto b = local[first + stride * K + K - 1 - t];
+                if (compare(b, a))
+                  a = b;
+              }
+            });
+            for (auto halfBoxSize = K / 2; halfBoxSize != 0; halfBoxSize /= 2)
+              g.parallel_for_work_item([=](h_item<1> it) {
+                for (auto id = it.get_local_id()[0]; id < nPairs * K / 2;
+                     id += WGSize) {
+                  auto first = id / (K / 2) * 2 * stride * K;
+                  auto t = id % (K / 2);
+                  auto id0 = first + t / halfBoxSize * 2 * halfBoxSize +
+                             t % halfBoxSize;
+                  auto id1 = id0 + halfBoxSize;
+                  if (compare(local[id1], local[id0]))
+                    std::swap(local[id0], local[id1]);
+                }
+              });
+          }
+
+          g.parallel_for_work_item([=](h_item<1> it) {
+            for (auto t = it.get_local_id()[0]; t < K; t += WGSize)
+              output[g.get_id(0) * K + t] = local[t];
+          });
+        });
+  });
+}
+
+// Writes the first k elements of data in the order of compare (the k
+// smallest for Less, the k largest for Greater) sorted to result
+// Passes of _BitonicTopKPass reduce the array WGElements / K times each
+// until a single run is left, so the work is O(size * log(k)^2) with
+// O(size * K / WGElements) elements going through global memory after the
+// first pass, instead of O(size * log(size)^2) of a full sort.
+// k larger than half of the local memory falls back to BitonicSortLocal.
+// Scratch memory comes from pool if given, the result is ready when the
+// returned event completes.
+template <typename T, typename Compare = Less>
+static cl::sycl::event
+BitonicTopK(cl::sycl::queue &queue, T const *data, size_t size, size_t k,
+            T *result, std::vector<cl::sycl::event> const &depEvents = {},
+            Compare compare = {}, UsmPool *pool = nullptr) {
+  using namespace cl::sycl;
+  k = std::min(k, size);
+  if (k == 0)
+    return JoinEvents(queue, depEvents);
+  auto K = std::max<size_t>(NextPowerOf2(k), 2);
+  auto config = GetBitonicLocalConfig(queue.get_device(), sizeof(T));
+  auto WGElements = config.WGSize * config.nElementsPerWorkItem;
+  if (2 * K > WGElements) {
+    auto *sorted = UsmAllocate<T>(queue, pool, size);
+    auto copied = queue.submit([&](handler &h) {
+      h.depends_on(depEvents);
+      h.memcpy(sorted, data, size * sizeof(T));
+    });
+    auto event = queue.submit([&](handler &h) {
+      h.depends_on(BitonicSortLocal(queue, sorted, size, {copied}, nullptr,
+                                    compare));
+      h.memcpy(result, sorted, k * sizeof(T));
+    });
+    UsmFree(queue, pool, sorted, {event});
+    return event;
+  }
+  // Tiles are not larger than the padded array, but hold two runs
+  WGElements =
+      std::max(2 * K, std::min<size_t>(WGElements, NextPowerOf2(size)));
+  auto WGSize = std::min<size_t>(config.WGSize, WGElements / 2);
+
+  // Passes alternate between two buffers for the runs of the first pass
+  auto nRuns = (size + WGElements - 1) / WGElements;
+  auto *scratch = UsmAllocate<T>(queue, pool, 2 * nRuns * K);
+  T *buffers[] = {scratch, scratch + nRuns * K};
+  auto *input = data;
+  auto events = depEvents;
+  for (auto pass = 0;; ++pass) {
+    auto *output = buffers[pass % 2];
+    events = {_BitonicTopKPass(queue, input, size, output, K, WGSize,
+                               WGElements, events, compare)};
+    input = output;
+    size = nRuns * K;
+    if (nRuns == 1)
+      break;
+    nRuns = (size + WGElements - 1) / WGElements;
+  }
+  auto event = queue.submit([&](handler &h) {
+    h.depends_on(events);
+    h.memcpy(result, input, k * sizeof(T));
+  });
+  UsmFree(queue, pool, scratch, {event});
+  return event;
+}
+
+template <typename T, typename Compare = Less>
+static std::vector<T> BitonicTopK(cl::sycl::queue &queue,
+                                  std::vector<T> const &vec, size_t k,
+                                  Compare compare = {},
+                                  UsmPool *pool = nullptr) {
+  using namespace cl::sycl;
+  auto size = vec.size();
+  k = std::min(k, size);
+  auto result = std::vector<T>(k);
+  if (k == 0)
+    return result;
+  auto *data = UsmAllocate<T>(queue, pool, size);
+  auto *top = UsmAllocate<T>(queue, pool, k);
+  auto copied = queue.submit(
+      [&](handler &h) { h.memcpy(data, vec.data(), size * sizeof(T)); });
+  auto found =
+      BitonicTopK(queue, data, size, k, top, {copied}, compare, pool);
+  auto copiedBack = queue.submit([&](handler &h) {
+    h.depends_on(found);
+    h.memcpy(result.data(), top, k * sizeof(T));
+  });
+  copiedBack.wait();
+  UsmFree(queue, pool, data);
+  UsmFree(queue, pool, top);
+  return result;
+}
@@ -1,34 +1,567 @@
+#include <execution>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#if __has_include(<tbb/global_control.h>)
+#include <tbb/global_control.h>
+#endif
+
 #ifdef ESIMDVER
 #include "bitonic_sort_esimd.hpp"
 #else
+#include "bitonic_sort_by_key.hpp"
+#include "bitonic_sort_chunked.hpp"
 #include "bitonic_sort_hier.hpp"
 #include "bitonic_sort_local.hpp"
 #include "bitonic_sort_naive.hpp"
+#include "bitonic_sort_plan.hpp"
+#include "bitonic_sort_segmented.hpp"
+#include "bitonic_sort_subgroup.hpp"
+#include "bitonic_sort_tuner.hpp"
+#include "bitonic_top_k.hpp"
+#include "../radix_sort/radix_sort.hpp"
 #endif
+#include "bitonic_sort_simd.hpp"
+#include "../merge_sort/merge_sort.hpp"
 #include "../utils.hpp"
 
-int main(int argc, char *argv[]) {
-  auto pow = GetIntArgument(argc, argv, 12);
-  auto size = static_cast<size_t>(1 << pow);
+// Copies vector to device memory, sorts it with USM overload of a sort and
+// copies it back, without waiting in between
+template <typename T, typename Sort>
+static void SortOnDevice(cl::sycl::queue &queue, std::vector<T> &vec,
+                         Sort &&sort, UsmPool *pool = nullptr) {
+  using namespace cl::sycl;
+  auto size = vec.size();
+  auto *data = UsmAllocate<T>(queue, pool, size);
+  auto copied = queue.submit(
+      [&](handler &h) { h.memcpy(data, vec.data(), size * sizeof(T)); });
+  auto sorted = sort(data, size, std::vector<event>{copied});
+  queue
+      .submit([&](handler &h) {
+        h.depends_on(sorted);
+        h.memcpy(vec.data(), data, size * sizeof(T));
+      })
+      .wait();
+  UsmFree(queue, pool, data);
+}
 
-  auto GPUSelector = cl::sycl::gpu_selector{};
-  auto queue = cl::sycl::queue{GPUSelector};
-  PrintInfo(queue, std::cout);
+// Record sorted by its key, payload depends on the key only, so sorts agree
+// though none of them is stable
+struct Record {
+  cl::sycl::cl_int key;
+  cl::sycl::cl_float payload;
+};
 
-  auto vec = GetRandomVector(size);
+static bool operator==(Record const &lhs, Record const &rhs) {
+  return lhs.key == rhs.key && lhs.payload == rhs.payload;
+}
 
-  WarmUp(queue);
+static std::ostream &operator<<(std::ostream &os, Record const &record) {
+  return os << "{" << record.key << ", " << record.payload << "}";
+}
 
-  Check(
-      vec, "CPU", [&](auto &v) { std::sort(v.begin(), v.end()); }
+struct RecordKey {
+  auto operator()(Record const &record) const { return record.key; }
+};
+
+// Checks the sorts taking a comparator on vec ordered by compare
+template <typename T, typename Compare>
+static void CheckOrder(cl::sycl::queue &queue, BenchmarkOptions const &options,
+                       std::vector<T> const &vec, std::string_view order,
+                       Compare compare) {
+  auto Name = [&](std::string_view sort) {
+    return std::string{sort} + ", " + std::string{order};
+  };
+  CheckBy(
+      options, compare, vec, Name("CPU"),
+      [&](auto &v) { std::sort(v.begin(), v.end(), compare); }
+#ifdef ESIMDVER
+      ,
+      Name("GPU with ESIMD"),
+      [&](auto &v) { BitonicSortESIMD(queue, v, nullptr, compare); }
+#else
+      ,
+      Name("GPU naive"),
+      [&](auto &v) { BitonicSortNaive(queue, v, compare); },
+      Name("GPU with local memory"),
+      [&](auto &v) { BitonicSortLocal(queue, v, compare); },
+      Name("GPU with local memory and 4 fused global steps"),
+      [&](auto &v) { BitonicSortLocal<4>(queue, v, compare); },
+      Name("GPU with local memory, nd_range"),
+      [&](auto &v) { BitonicSortLocalND(queue, v, compare); },
+      Name("GPU with PFWI"),
+      [&](auto &v) { BitonicSortHier(queue, v, compare); },
+      Name("GPU with nd_range work groups"),
+      [&](auto &v) { BitonicSortHierND(queue, v, compare); },
+      Name("GPU with sub-group shuffles"),
+      [&](auto &v) { BitonicSortSubGroup(queue, v, compare); }
+#endif
+  );
+}
+
+// Sorts of other element types and orders, floating point values include
+// NaNs, infinities, signed zeros and denormals
+static void CheckTypes(cl::sycl::queue &queue, BenchmarkOptions const &options,
+                       size_t size) {
+  using namespace cl::sycl;
+  auto ints = GetRandomVector<cl_int>(size);
+  CheckOrder(queue, options, ints, "cl_int descending", Greater{});
+  auto floats = GetRandomVector<cl_float>(size);
+  AddSpecialValues(floats);
+  CheckOrder(queue, options, floats, "cl_float total order",
+             TotalOrderLess{});
+  CheckOrder(queue, options, floats, "cl_float descending total order",
+             TotalOrderGreater{});
+#ifndef ESIMDVER
+  // ESIMD gathers 32-bit elements only
+  CheckOrder(queue, options, GetRandomVector<cl_long>(size), "cl_long",
+             Less{});
+  auto doubles = GetRandomVector<cl_double>(size);
+  AddSpecialValues(doubles);
+  CheckOrder(queue, options, doubles, "cl_double total order",
+             TotalOrderLess{});
+  auto records = std::vector<Record>();
+  for (auto key : GetRandomVector<cl_int>(size))
+    records.push_back({key, static_cast<cl_float>(key % 1000) / 8});
+  CheckOrder(queue, options, records, "records by key",
+             CompareBy{RecordKey{}});
+  CheckOrder(queue, options, records, "records by key descending",
+             CompareBy{RecordKey{}, Greater{}});
+#endif
+}
+
+#ifndef ESIMDVER
+// Payloads of by-key sorts are original positions of keys, so every payload
+// must travel with its key: sorted keys[i] == original keys[payload[i]], and
+// payloads stay a permutation. Indices of argsorts are checked the same way.
+template <typename Compare>
+static void CheckByKey(cl::sycl::queue &queue,
+                       std::vector<cl::sycl::cl_int> const &vec,
+                       std::string_view order, Compare compare) {
+  using namespace cl::sycl;
+  auto size = vec.size();
+  auto CheckPermutation = [&](std::vector<cl_int> const &keys,
+                              std::vector<cl_uint> const &indices,
+                              std::string const &description) {
+    auto seen = std::vector<bool>(size);
+    for (auto i = size_t{0}; i != size; ++i) {
+      auto index = indices[i];
+      if (index >= size || seen[index] || keys[i] != vec[index] ||
+          (i && compare(keys[i], keys[i - 1]))) {
+        auto message = std::stringstream{};
+        message << std::endl
+                << "Result of \"" << description << "\" is wrong at pos " << i
+                << std::endl;
+        throw std::runtime_error{message.str()};
+      }
+      seen[index] = true;
+    }
+  };
+  for (auto layout : {KeyValueLayout::SoA, KeyValueLayout::Packed}) {
+    auto name = std::string{layout == KeyValueLayout::SoA ? "SoA" : "packed"} +
+                ", " + std::string{order};
+    auto keys = vec;
+    auto payload = std::vector<cl_uint>(size);
+    std::iota(payload.begin(), payload.end(), 0);
+    BitonicSortByKey(queue, keys, payload, layout, compare);
+    CheckPermutation(keys, payload, "GPU by key (" + name + ")");
+    auto indices = BitonicArgSort(queue, vec, layout, compare);
+    for (auto i = size_t{0}; i != size; ++i)
+      keys[i] = vec[indices[i]];
+    CheckPermutation(keys, indices, "GPU argsort (" + name + ")");
+  }
+  std::cout << "GPU by key and argsort, " << order << ": OK" << std::endl;
+}
+#endif
+
+// Builds the kernels of the benchmarks on cl_int, the ones of other types
+// and orders are built on first use
+static void Prebuild(cl::sycl::queue &queue) {
+  using namespace cl::sycl;
+#ifdef ESIMDVER
+  PrebuildKernels(queue, BitonicSortESIMDKernels<cl_int>{});
+#else
+  PrebuildKernels(queue, BitonicSortNaiveKernels<cl_int>{},
+                  BitonicSortLocalKernels<cl_int>{},
+                  BitonicSortLocalKernels<cl_int, Less, 4>{},
+                  BitonicSortLocalNDKernels<cl_int>{},
+                  BitonicSortHierKernels<cl_int>{},
+                  BitonicSortHierNDKernels<cl_int>{},
+                  BitonicSortSubGroupKernels<cl_int>{},
+                  RadixSortKernels<cl_int>{},
+                  BitonicSortByKeyKernels<cl_int, cl_uint>{},
+                  BitonicSortSegmentedKernels<cl_int>{},
+                  BitonicTopKKernels<cl_int>{});
+#endif
+}
+
+// Start-up time of the device sorts on size elements, see CheckStartup
+static void PrintStartupTimes(cl::sycl::queue &queue, size_t size) {
+  auto vec = GetRandomVector(size);
+  std::cout << "Start-up on vector of " << size << " elements" << std::endl;
+  CheckStartup(
+      queue, vec
 #ifdef ESIMDVER
       ,
-      "GPU with ESIMD", [&](auto &v) { BitonicSortESIMD(queue, v); }
+      "GPU with ESIMD", [](auto &q, auto &v) { BitonicSortESIMD(q, v); }
+#else
+      ,
+      "GPU naive", [](auto &q, auto &v) { BitonicSortNaive(q, v); },
+      "GPU with local memory", [](auto &q, auto &v) { BitonicSortLocal(q, v); },
+      "GPU with local memory and 4 fused global steps",
+      [](auto &q, auto &v) { BitonicSortLocal<4>(q, v); },
+      "GPU with PFWI", [](auto &q, auto &v) { BitonicSortHier(q, v); },
+      "GPU with sub-group shuffles",
+      [](auto &q, auto &v) { BitonicSortSubGroup(q, v); },
+      "GPU radix", [](auto &q, auto &v) { RadixSort(q, v); },
+      "GPU top k", [](auto &q, auto &v) { v = BitonicTopK(q, v, 16); }
+#endif
+  );
+  std::cout << std::endl;
+}
+
+// Device time of every command of the sorts, transfers to and from the
+// device are done explicitly on USM. The sorts run on a profiling queue of
+// the same context, so that the benchmarks are timed without profiling.
+template <typename T>
+static void PrintProfiles(cl::sycl::queue const &benchmarkQueue,
+                          std::vector<T> const &vec, UsmPool &usmPool) {
+  using namespace cl::sycl;
+  auto queue = cl::sycl::queue{benchmarkQueue.get_context(),
+                               benchmarkQueue.get_device(),
+                               property::queue::enable_profiling{}};
+  auto Profile = [&](std::string_view description, auto &&sort) {
+    auto v = vec;
+    std::cout << description << " device time:" << std::endl;
+    PrintProfile(ProfileSort(queue, v, sort, &usmPool), std::cout);
+  };
+#ifdef ESIMDVER
+  auto v = vec;
+  auto profile = BitonicProfile{};
+  BitonicSortESIMD(queue, v, &profile);
+  std::cout << "GPU with ESIMD device time:" << std::endl;
+  PrintProfile(profile, std::cout);
 #else
+  Profile("GPU naive", [&](auto *data, auto size, auto deps, auto *profile) {
+    return BitonicSortNaive(queue, data, size, deps, profile);
+  });
+  Profile("GPU with local memory",
+          [&](auto *data, auto size, auto deps, auto *profile) {
+            return BitonicSortLocal(queue, data, size, deps, profile);
+          });
+  Profile("GPU with local memory and 4 fused global steps",
+          [&](auto *data, auto size, auto deps, auto *profile) {
+            return BitonicSortLocal<4>(queue, data, size, deps, profile);
+          });
+  Profile("GPU with local memory, nd_range",
+          [&](auto *data, auto size, auto deps, auto *profile) {
+            return BitonicSortLocalND(queue, data, size, deps, profile);
+          });
+  Profile("GPU with PFWI",
+          [&](auto *data, auto size, auto deps, auto *profile) {
+            return BitonicSortHier(queue, data, size, deps, profile);
+          });
+  Profile("GPU with nd_range work groups",
+          [&](auto *data, auto size, auto deps, auto *profile) {
+            return BitonicSortHierND(queue, data, size, deps, profile);
+          });
+  Profile("GPU with sub-group shuffles",
+          [&](auto *data, auto size, auto deps, auto *profile) {
+            return BitonicSortSubGroup(queue, data, size, deps, profile);
+          });
+#endif
+  std::cout << std::endl;
+}
+
+// Parallel CPU sorts on 1, 2, 4... up to maxThreads threads
+// Parallel algorithms of the standard library run on TBB, which is limited
+// to the number of threads when its headers are available.
+static void CheckThreadScaling(BenchmarkOptions const &options,
+                               std::vector<cl::sycl::cl_int> const &vec,
+                               size_t maxThreads) {
+  auto nThreadsList = std::vector<size_t>();
+  for (auto nThreads = size_t{1}; nThreads < maxThreads; nThreads *= 2)
+    nThreadsList.push_back(nThreads);
+  nThreadsList.push_back(maxThreads);
+  for (auto nThreads : nThreadsList) {
+    auto pool = ThreadPool{nThreads};
+    auto suffix = ", " + std::to_string(nThreads) + " threads";
+    Check(
+        options, vec, "CPU par_unseq" + suffix,
+        [&](auto &v) {
+#if __has_include(<tbb/global_control.h>)
+          auto limit = tbb::global_control{
+              tbb::global_control::max_allowed_parallelism, nThreads};
+#endif
+          std::sort(std::execution::par_unseq, v.begin(), v.end());
+        },
+        "CPU merge sort" + suffix,
+        [&](auto &v) { ParallelMergeSort(pool, v); },
+        "CPU bitonic " + ToString(GetHostISA()) + suffix,
+        [&](auto &v) { BitonicSortSIMD(pool, v); });
+  }
+}
+
+// Benchmarks all sorts on vectors of about size elements
+// The main competitors run on every distribution, the other benchmarks on
+// uniform values. Device memory of the USM sorts comes from usmPool, so only
+// the first run of every size allocates.
+static void RunBenchmarks(cl::sycl::queue &queue,
+                          BenchmarkOptions const &options,
+                          std::vector<Distribution> const &distributions,
+                          size_t size, size_t maxThreads, bool profile,
+                          UsmPool &usmPool) {
+  auto pool = ThreadPool{maxThreads};
+#ifndef ESIMDVER
+  // Built once for both sizes
+  auto plan = SortPlan<cl::sycl::cl_int>{queue, size};
+#endif
+  // Power of two and an arbitrary odd size of the same order
+  for (auto currentSize : {size, size - size / 4 + 1})
+    for (auto distribution : distributions) {
+      auto distributionOptions = options;
+      distributionOptions.distribution = ToString(distribution);
+      auto vec = GetRandomVector(currentSize, distribution);
+#ifndef ESIMDVER
+      // Stages of the last run of the chunked sort, printed after the timings
+      auto chunkedStats = ChunkedSortStats{};
+#endif
+      Check(
+          distributionOptions, vec, "CPU",
+          [&](auto &v) { std::sort(v.begin(), v.end()); },
+          "CPU bitonic " + ToString(GetHostISA()),
+          [&](auto &v) { BitonicSortSIMD(pool, v); }
+#ifdef ESIMDVER
+          ,
+          "GPU with ESIMD", [&](auto &v) { BitonicSortESIMD(queue, v); }
+#else
+          ,
+          "GPU naive", [&](auto &v) { BitonicSortNaive(queue, v); },
+          "GPU with local memory", [&](auto &v) { BitonicSortLocal(queue, v); },
+          "GPU with local memory and 4 fused global steps",
+          [&](auto &v) { BitonicSortLocal<4>(queue, v); },
+          "GPU with local memory, nd_range",
+          [&](auto &v) { BitonicSortLocalND(queue, v); },
+          "GPU with PFWI", [&](auto &v) { BitonicSortHier(queue, v); },
+          "GPU with nd_range work groups",
+          [&](auto &v) { BitonicSortHierND(queue, v); },
+          "GPU with sub-group shuffles",
+          [&](auto &v) { BitonicSortSubGroup(queue, v); },
+          "GPU radix", [&](auto &v) { RadixSort(queue, v); },
+          "GPU out-of-core in 8 chunks",
+          [&](auto &v) {
+            chunkedStats = BitonicSortChunked(queue, v, (v.size() + 7) / 8);
+          },
+          "GPU with local memory on USM",
+          [&](auto &v) {
+            SortOnDevice(
+                queue, v,
+                [&](auto *data, auto size, auto deps) {
+                  return BitonicSortLocal(queue, data, size, deps);
+                },
+                &usmPool);
+          },
+          "GPU with local memory and a sort plan",
+          [&](auto &v) { plan.Sort(v); },
+          "GPU by key (SoA)",
+          [&](auto &v) {
+            auto payload = std::vector<cl::sycl::cl_uint>(v.size());
+            std::iota(payload.begin(), payload.end(), 0);
+            BitonicSortByKey(queue, v, payload, KeyValueLayout::SoA);
+          },
+          "GPU by key (packed)",
+          [&](auto &v) {
+            auto payload = std::vector<cl::sycl::cl_uint>(v.size());
+            std::iota(payload.begin(), payload.end(), 0);
+            BitonicSortByKey(queue, v, payload, KeyValueLayout::Packed);
+          }
+#endif
+      );
+#ifndef ESIMDVER
+      std::cout << "GPU out-of-core in 8 chunks, last run:" << std::endl;
+      PrintStats(chunkedStats, std::cout);
+#endif
+      CheckThreadScaling(distributionOptions, vec, maxThreads);
+      if (profile)
+        PrintProfiles(queue, vec, usmPool);
+    }
+
+  CheckTypes(queue, options, size);
+#ifndef ESIMDVER
+  auto keys = GetRandomVector(size);
+  for (auto &key : keys)
+    key %= 1000;
+  CheckByKey(queue, keys, "duplicate keys", Less{});
+  CheckByKey(queue, keys, "duplicate keys descending", Greater{});
+
+  // Results are the first k elements in the order, so they are compared
+  // exactly. The last k has runs of more than half of the local memory of a
+  // work group, where BitonicTopK falls back to BitonicSortLocal.
+  auto topKOptions = options;
+  topKOptions.verification = Verification::Exact;
+  auto config =
+      GetBitonicLocalConfig(queue.get_device(), sizeof(cl::sycl::cl_int));
+  auto fallbackK = config.WGSize * config.nElementsPerWorkItem / 2 + 1;
+  auto CheckTopK = [&](size_t k, std::string_view order, auto compare) {
+    auto vec = GetRandomVector(size);
+    std::cout << "Top " << k << ", " << order << std::endl;
+    auto Truncate = [&](auto &v) { v.resize(std::min(k, v.size())); };
+    Check(
+        topKOptions, vec, "CPU partial sort",
+        [&](auto &v) {
+          std::partial_sort(v.begin(), v.begin() + std::min(k, v.size()),
+                            v.end(), compare);
+          Truncate(v);
+        },
+        "GPU with local memory and truncation",
+        [&](auto &v) {
+          BitonicSortLocal(queue, v, compare);
+          Truncate(v);
+        },
+        "GPU top k",
+        [&](auto &v) { v = BitonicTopK(queue, v, k, compare, &usmPool); });
+  };
+  for (auto k : {size_t{16}, size_t{1024}, fallbackK}) {
+    CheckTopK(k, "smallest", Less{});
+    CheckTopK(k, "largest", Greater{});
+  }
+
+  // Segments of random length from 64 to 4096 elements
+  auto vec = GetRandomVector(size);
+  auto offsets = std::vector<size_t>{0};
+  for (auto length : GetRandomVector<cl::sycl::cl_uint>(size / 64 + 1)) {
+    if (offsets.back() == size)
+      break;
+    offsets.push_back(std::min(size, offsets.back() + 64 + length % 4033));
+  }
+  std::cout << offsets.size() - 1 << " segments" << std::endl;
+  auto ForEachSegment = [&](auto &v, auto &&sort) {
+    for (auto i = size_t{0}; i + 1 < offsets.size(); ++i) {
+      auto segment = std::vector(v.begin() + offsets[i],
+                                 v.begin() + offsets[i + 1]);
+      sort(segment);
+      std::copy(segment.begin(), segment.end(), v.begin() + offsets[i]);
+    }
+  };
+  // Results are sorted per segment only, so they are compared exactly
+  auto segmentedOptions = options;
+  segmentedOptions.verification = Verification::Exact;
+  Check(
+      segmentedOptions, vec, "CPU segmented",
+      [&](auto &v) {
+        ForEachSegment(v, [](auto &s) { std::sort(s.begin(), s.end()); });
+      },
+      "GPU with local memory per segment",
+      [&](auto &v) {
+        ForEachSegment(v, [&](auto &s) { BitonicSortLocal(queue, s); });
+      },
+      "GPU segmented",
+      [&](auto &v) {
+        BitonicSortSegmented(queue, v, offsets, Less{}, &usmPool);
+      });
+#endif
+}
+
+// Sizes beyond 2^31 elements, where kernels use 64-bit indices (see
+// WithIndexType), run only the parallel sorts on uniform values
+static void RunLargeBenchmarks(cl::sycl::queue &queue,
+                               BenchmarkOptions const &options, size_t size,
+                               size_t maxThreads, UsmPool &usmPool) {
+  auto pool = ThreadPool{maxThreads};
+  auto vec = GetRandomVector(size);
+  Check(
+      options, vec, "CPU par_unseq",
+      [&](auto &v) {
+        std::sort(std::execution::par_unseq, v.begin(), v.end());
+      },
+      "CPU merge sort", [&](auto &v) { ParallelMergeSort(pool, v); }
+#ifndef ESIMDVER
       ,
-      "GPU naive", [&](auto &v) { BitonicSortNaive(queue, v); },
-      "GPU with local memory", [&](auto &v) { BitonicSortLocal(queue, v); },
-      "GPU with PFWI", [&](auto &v) { BitonicSortHier(queue, v); }
+      "GPU with local memory on USM",
+      [&](auto &v) {
+        SortOnDevice(
+            queue, v,
+            [&](auto *data, auto size, auto deps) {
+              return BitonicSortLocal(queue, data, size, deps);
+            },
+            &usmPool);
+      },
+      "GPU with local memory and 4 fused global steps on USM",
+      [&](auto &v) {
+        SortOnDevice(
+            queue, v,
+            [&](auto *data, auto size, auto deps) {
+              return BitonicSortLocal<4>(queue, data, size, deps);
+            },
+            &usmPool);
+      },
+      "GPU radix", [&](auto &v) { RadixSort(queue, v); }
 #endif
   );
 }
+
+// Sizes from 2^pow to 2^maxPow are benchmarked in a single run:
+// ./a.out pow [maxPow] [--warmups=N] [--repeats=N] [--csv=path] [--json=path]
+// Sizes from 2^32 run only the sorts of RunLargeBenchmarks
+// --threads=N is the largest number of threads of the parallel CPU sorts, all
+// hardware threads by default
+// --profile additionally prints device time of every kernel and transfer
+// --device=cpu|gpu|host|accelerator|all|<name> selects devices, see GetDevices
+// --distribution=uniform|sorted|reverse|few-unique|zipf|nearly-sorted|all,
+// several are separated by commas, and --seed=N reproduces the inputs
+// --verify=exact compares the results with the one of std::sort instead of
+// checking their sortedness and hash
+// --tune tunes BitonicSortLocal on 2^maxPow elements before the benchmarks
+// --startup prints cold, prebuilt and warm start-up time of the device sorts
+int main(int argc, char *argv[]) {
+  using namespace cl::sycl;
+  auto pow = GetIntArgument(argc, argv, 12);
+  auto maxPow = GetIntArgument(argc, argv, pow, 1);
+  auto options = GetBenchmarkOptions(argc, argv);
+  auto maxThreads = static_cast<size_t>(std::stoul(GetOption(
+      argc, argv, "threads",
+      std::to_string(std::max(std::thread::hardware_concurrency(), 1u)))));
+  auto profile = GetOption(argc, argv, "profile") == "1";
+  auto tune = GetOption(argc, argv, "tune") == "1";
+  auto startup = GetOption(argc, argv, "startup") == "1";
+  auto distributions = GetDistributions(argc, argv);
+  std::cout << "Random seed: " << RandomSeed() << std::endl;
+
+  for (auto const &device : GetDevices(argc, argv)) {
+    auto queue = cl::sycl::queue{device};
+    options.device = device.get_info<info::device::name>();
+    PrintInfo(queue, std::cout);
+
+    Prebuild(queue);
+    if (startup)
+      PrintStartupTimes(queue, size_t{1} << pow);
+
+#ifndef ESIMDVER
+    if (tune) {
+      std::cout << "Tuning BitonicSortLocal..." << std::endl;
+      auto config = TuneBitonicSortLocal<cl_int>(
+          queue, size_t{1} << maxPow, 3, &std::cout);
+      std::cout << "Tuned work group of " << config.WGSize << ", "
+                << config.nElementsPerWorkItem << " elements per work item"
+                << std::endl
+                << std::endl;
+    }
+#endif
+
+    auto usmPool = UsmPool{queue};
+    for (auto currentPow = pow; currentPow <= maxPow; ++currentPow) {
+      if (currentPow > 31)
+        RunLargeBenchmarks(queue, options, size_t{1} << currentPow,
+                           maxThreads, usmPool);
+      else
+        RunBenchmarks(queue, options, distributions, size_t{1} << currentPow,
+                      maxThreads, profile, usmPool);
+      // Blocks of this size are not reused by the larger ones
+      usmPool.Trim();
+    }
+    auto stats = usmPool.GetStats();
+    std::cout << "USM pool: " << stats.nHits << " hits, " << stats.nMisses
+              << " misses, at most " << stats.maxBytesReserved
+              << " bytes reserved" << std::endl;
+  }
+}
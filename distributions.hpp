@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "parallel.hpp"
+
+// Philox4x32-10 counter-based generator, Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3"
+// Every counter gives 4 independent random words, so elements are generated
+// in any order and in parallel with the same result.
+static std::array<std::uint32_t, 4>
+Philox4x32(std::array<std::uint32_t, 4> counter,
+           std::array<std::uint32_t, 2> key) {
+  auto constexpr M0 = std::uint64_t{0xD2511F53};
+  auto constexpr M1 = std::uint64_t{0xCD9E8D57};
+  auto constexpr W0 = std::uint32_t{0x9E3779B9};
+  auto constexpr W1 = std::uint32_t{0xBB67AE85};
+  for (auto round = 0; round != 10; ++round) {
+    auto product0 = M0 * counter[0];
+    auto product1 = M1 * counter[2];
+    counter = {static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^
+                   key[0],
+               static_cast<std::uint32_t>(product1),
+               static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^
+                   key[1],
+               static_cast<std::uint32_t>(product0)};
+    key[0] += W0;
+    key[1] += W1;
+  }
+  return counter;
+}
+
+enum class Distribution {
+  Uniform,
+  Sorted,
+  Reverse,
+  FewUnique,
+  Zipf,
+  NearlySorted
+};
+
+static std::vector<Distribution> const AllDistributions = {
+    Distribution::Uniform,   Distribution::Sorted, Distribution::Reverse,
+    Distribution::FewUnique, Distribution::Zipf,   Distribution::NearlySorted};
+
+static std::string ToString(Distribution distribution) {
+  switch (distribution) {
+  case Distribution::Uniform:
+    return "uniform";
+  case Distribution::Sorted:
+    return "sorted";
+  case Distribution::Reverse:
+    return "reverse";
+  case Distribution::FewUnique:
+    return "few-unique";
+  case Distribution::Zipf:
+    return "zipf";
+  case Distribution::NearlySorted:
+    return "nearly-sorted";
+  }
+  return {};
+}
+
+// Comma-separated names of distributions or "all"
+static std::vector<Distribution> ParseDistributions(std::string_view names) {
+  if (names == "all")
+    return AllDistributions;
+  auto distributions = std::vector<Distribution>();
+  while (!names.empty()) {
+    auto name = names.substr(0, names.find(','));
+    names.remove_prefix(std::min(names.size(), name.size() + 1));
+    auto found = std::find_if(AllDistributions.begin(), AllDistributions.end(),
+                              [&](Distribution distribution) {
+                                return ToString(distribution) == name;
+                              });
+    if (found == AllDistributions.end())
+      throw std::runtime_error{"Unknown distribution \"" + std::string(name) +
+                               "\""};
+    distributions.push_back(*found);
+  }
+  return distributions;
+}
+
+// Uniform in [0, 1) from 53 random bits
+static double _ToUnit(std::uint32_t hi, std::uint32_t lo) {
+  auto bits = (std::uint64_t{hi} << 21) ^ (lo >> 11);
+  return static_cast<double>(bits) * 0x1p-53;
+}
+
+// i-th of size evenly spaced increasing values covering the range of uniform
+// values of T
+template <typename T> static T _RampValue(size_t i, size_t size) {
+  if constexpr (std::is_floating_point_v<T>)
+    return static_cast<T>(2.0 * i - static_cast<double>(size));
+  else {
+    using U = std::make_unsigned_t<T>;
+    auto lowest = static_cast<U>(std::numeric_limits<T>::lowest());
+    auto range = static_cast<U>(static_cast<U>(std::numeric_limits<T>::max()) -
+                                lowest);
+    auto step = static_cast<U>(range / std::max<size_t>(size, 1));
+    return static_cast<T>(static_cast<U>(lowest + static_cast<U>(i) * step));
+  }
+}
+
+template <typename T>
+static T _UniformValue(std::array<std::uint32_t, 4> const &words,
+                       size_t size) {
+  if constexpr (std::is_floating_point_v<T>) {
+    auto bound = static_cast<double>(size);
+    return static_cast<T>(-bound + 2 * bound * _ToUnit(words[0], words[1]));
+  } else
+    return static_cast<T>((std::uint64_t{words[0]} << 32) | words[1]);
+}
+
+// Vector of size elements of T from stream of seed, the same arguments give
+// the same vector on any number of threads:
+// - uniform: integers over the whole range of T, floating point values over
+//   [-size, size]
+// - sorted, reverse: evenly spaced values over the same range
+// - few-unique: 16 distinct values
+// - zipf: value k with probability about proportional to 1 / k, k in [1, size]
+// - nearly-sorted: sorted with 1% of elements replaced by uniform ones
+template <typename T>
+static std::vector<T> GenerateVector(size_t size, Distribution distribution,
+                                     std::uint64_t seed,
+                                     std::uint64_t stream = 0) {
+  auto constexpr nFewUnique = size_t{16};
+  auto constexpr nearlySortedNoise = 0.01;
+  auto vec = std::vector<T>(size);
+  auto key = std::array<std::uint32_t, 2>{
+      static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+  auto logSize = std::log(static_cast<double>(size) + 1);
+  _ParallelFor(size, [&](size_t i) {
+    auto words = Philox4x32({static_cast<std::uint32_t>(i),
+                             static_cast<std::uint32_t>(std::uint64_t{i} >> 32),
+                             static_cast<std::uint32_t>(stream),
+                             static_cast<std::uint32_t>(stream >> 32)},
+                            key);
+    auto unit = _ToUnit(words[2], words[3]);
+    switch (distribution) {
+    case Distribution::Uniform:
+      vec[i] = _UniformValue<T>(words, size);
+      break;
+    case Distribution::Sorted:
+      vec[i] = _RampValue<T>(i, size);
+      break;
+    case Distribution::Reverse:
+      vec[i] = _RampValue<T>(size - 1 - i, size);
+      break;
+    case Distribution::FewUnique:
+      vec[i] = _RampValue<T>(words[0] % nFewUnique, nFewUnique);
+      break;
+    case Distribution::Zipf:
+      // Inverse of the continuous approximation of the distribution function
+      vec[i] = static_cast<T>(
+          std::min(size, static_cast<size_t>(std::exp(unit * logSize))));
+      break;
+    case Distribution::NearlySorted:
+      vec[i] = unit < nearlySortedNoise ? _UniformValue<T>(words, size)
+                                        : _RampValue<T>(i, size);
+      break;
+    }
+  });
+  return vec;
+}
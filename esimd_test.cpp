@@ -3,6 +3,8 @@
 #include <CL/sycl.hpp>
 #include <CL/sycl/INTEL/esimd.hpp>
 
+#include "utils.hpp"
+
 template <typename T>
 void FillESIMD(cl::sycl::queue &queue, std::vector<T> &vec) {
   using namespace cl::sycl;
@@ -28,12 +30,11 @@ void FillESIMD(cl::sycl::queue &queue, std::vector<T> &vec) {
   buf.template get_access<access::mode::read_write>();
 }
 
-int main() {
+int main(int argc, char *argv[]) {
   auto size = 16;
   auto vec = std::vector<int>(size);
 
-  auto GPUSelector = cl::sycl::gpu_selector{};
-  auto queue = cl::sycl::queue{GPUSelector};
+  auto queue = cl::sycl::queue{GetDevice(argc, argv)};
 
   FillESIMD(queue, vec);
 
@@ -1,5 +1,7 @@
 #include <CL/sycl.hpp>
 
+#include "utils.hpp"
+
 void FillLambda(cl::sycl::queue &queue, std::vector<int> &vec,
                 size_t workGroupSize) {
   using namespace cl::sycl;
@@ -42,7 +44,7 @@ void FillWithoutLambda(cl::sycl::queue &queue, std::vector<int> &vec,
   buf.template get_access<cl::sycl::access::mode::read_write>();
 }
 
-int main() {
+int main(int argc, char *argv[]) {
   auto size = 16;
   auto workGroupSize = 4;
   auto nWorkGroups = size / workGroupSize;
@@ -50,8 +52,7 @@ int main() {
   auto lambdaVec = emptyVec;
   auto withoutLambdaVec = emptyVec;
 
-  auto GPUSelector = cl::sycl::gpu_selector{};
-  auto queue = cl::sycl::queue{GPUSelector};
+  auto queue = cl::sycl::queue{GetDevice(argc, argv)};
 
   FillLambda(queue, lambdaVec, workGroupSize);
   FillWithoutLambda(queue, withoutLambdaVec, workGroupSize);
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <vector>
+
+#include "../utils.hpp"
+#include "thread_pool.hpp"
+
+// Ranges of at most this many elements are sorted and merged sequentially
+static size_t constexpr MergeSortGrainSize = 1 << 14;
+
+// Merges two sorted ranges to out by splitting the larger one in the middle
+// and the other one at the same value, the two halves are merged in parallel
+template <typename It, typename OutIt, typename Compare>
+static void _ParallelMerge(ThreadPool &pool, It first1, It last1, It first2,
+                           It last2, OutIt out, Compare compare) {
+  auto size1 = static_cast<size_t>(last1 - first1);
+  auto size2 = static_cast<size_t>(last2 - first2);
+  if (size1 + size2 <= MergeSortGrainSize) {
+    std::merge(first1, last1, first2, last2, out, compare);
+    return;
+  }
+  auto middle1 = It{};
+  auto middle2 = It{};
+  if (size1 >= size2) {
+    middle1 = first1 + size1 / 2;
+    middle2 = std::lower_bound(first2, last2, *middle1, compare);
+  } else {
+    middle2 = first2 + size2 / 2;
+    middle1 = std::upper_bound(first1, last1, *middle2, compare);
+  }
+  auto done = std::atomic<bool>{false};
+  pool.Submit([&]() {
+    _ParallelMerge(pool, first1, middle1, first2, middle2, out, compare);
+    done = true;
+  });
+  _ParallelMerge(pool, middle1, last1, middle2, last2,
+                 out + (middle1 - first1) + (middle2 - first2), compare);
+  pool.Wait([&]() { return done.load(); });
+}
+
+// Sorts [first, last) leaving the result there or in buffer of the same size
+// Halves are sorted to the other of the two arrays and merged back, so
+// every level of the recursion moves the elements once.
+template <typename It, typename Compare>
+static void _ParallelMergeSort(ThreadPool &pool, It first, It last,
+                               It buffer, bool toBuffer, Compare compare) {
+  auto size = static_cast<size_t>(last - first);
+  if (size <= MergeSortGrainSize) {
+    std::sort(first, last, compare);
+    if (toBuffer)
+      std::move(first, last, buffer);
+    return;
+  }
+  auto half = size / 2;
+  auto done = std::atomic<bool>{false};
+  pool.Submit([&]() {
+    _ParallelMergeSort(pool, first, first + half, buffer, !toBuffer, compare);
+    done = true;
+  });
+  _ParallelMergeSort(pool, first + half, last, buffer + half, !toBuffer,
+                     compare);
+  pool.Wait([&]() { return done.load(); });
+
+  auto from = toBuffer ? first : buffer;
+  auto to = toBuffer ? buffer : first;
+  _ParallelMerge(pool, from, from + half, from + half, from + size, to,
+                 compare);
+}
+
+// Parallel merge sort on the threads of pool, without SYCL
+template <typename T, typename Compare = Less>
+static void ParallelMergeSort(ThreadPool &pool, std::vector<T> &vec,
+                              Compare compare = {}) {
+  if (vec.size() <= 1)
+    return;
+  auto buffer = std::vector<T>(vec.size());
+  _ParallelMergeSort(pool, vec.begin(), vec.end(), buffer.begin(), false,
+                     compare);
+}
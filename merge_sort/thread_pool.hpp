@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool of nThreads threads, one of which is the thread calling
+// Wait, so a single thread may use the pool at a time
+// Every thread has a deque of tasks: it takes the newest task of its own
+// deque, which keeps the data of a divide and conquer task in its cache, and
+// steals the oldest (largest) task of another thread when its deque is empty.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t nThreads)
+      : queues(std::max<size_t>(nThreads, 1)) {
+    for (auto &queue : queues)
+      queue = std::make_unique<Queue>();
+    for (auto i = size_t{1}; i < queues.size(); ++i)
+      workers.emplace_back([this, i]() {
+        _Index() = i;
+        while (!stopping)
+          if (!RunTask()) {
+            auto lock = std::unique_lock{sleepMutex};
+            wakeUp.wait(lock, [&]() { return stopping || nQueued != 0; });
+          }
+      });
+  }
+
+  ~ThreadPool() {
+    {
+      auto lock = std::lock_guard{sleepMutex};
+      stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool &operator=(ThreadPool const &) = delete;
+
+  size_t Size() const { return queues.size(); }
+
+  // Task goes to the deque of the calling thread
+  void Submit(std::function<void()> task) {
+    // Counted before it is queued, so the count never goes below zero
+    {
+      auto lock = std::lock_guard{sleepMutex};
+      ++nQueued;
+    }
+    auto &queue = *queues[_Index()];
+    {
+      auto lock = std::lock_guard{queue.mutex};
+      queue.tasks.push_back(std::move(task));
+    }
+    wakeUp.notify_one();
+  }
+
+  // Runs tasks until done() is true, so waiting for a subtask never blocks
+  // a thread the subtask needs
+  template <typename Done> void Wait(Done &&done) {
+    while (!done())
+      if (!RunTask())
+        std::this_thread::yield();
+  }
+
+  // Runs f(i) for every i in [0, n) and waits for all of them
+  template <typename F> void ParallelFor(size_t n, F &&f) {
+    auto nDone = std::atomic<size_t>{0};
+    for (auto i = size_t{1}; i < n; ++i)
+      Submit([&, i]() {
+        f(i);
+        ++nDone;
+      });
+    if (n != 0) {
+      f(0);
+      ++nDone;
+    }
+    Wait([&]() { return nDone == n; });
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  // Index of the deque of the calling thread, threads outside of the pool
+  // use the first one
+  static size_t &_Index() {
+    thread_local auto index = size_t{0};
+    return index;
+  }
+
+  bool RunTask() {
+    auto task = std::function<void()>();
+    auto self = _Index();
+    for (auto i = size_t{0}; i != queues.size() && !task; ++i) {
+      auto &queue = *queues[(self + i) % queues.size()];
+      auto lock = std::lock_guard{queue.mutex};
+      if (queue.tasks.empty())
+        continue;
+      if (i == 0) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+    }
+    if (!task)
+      return false;
+    {
+      auto lock = std::lock_guard{sleepMutex};
+      --nQueued;
+    }
+    task();
+    return true;
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::mutex sleepMutex;
+  std::condition_variable wakeUp;
+  // Both are guarded by sleepMutex, stopping is also read without it
+  size_t nQueued = 0;
+  std::atomic<bool> stopping{false};
+};
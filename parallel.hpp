@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Splits [0, size) into a chunk per hardware thread, at least minChunk
+// elements each, and returns f(first, last) of every chunk in order
+template <typename F> static auto _ParallelChunks(size_t size, F const &f) {
+  auto constexpr minChunk = size_t{1} << 16;
+  auto nThreads = std::min<size_t>(
+      std::max(std::thread::hardware_concurrency(), 1u),
+      (size + minChunk - 1) / minChunk);
+  using Result = decltype(f(size_t{0}, size_t{0}));
+  // Elements of std::vector<bool> cannot be written concurrently
+  static_assert(!std::is_same_v<Result, bool>);
+  auto results = std::vector<Result>(nThreads);
+  auto Run = [&](size_t thread) {
+    results[thread] =
+        f(size * thread / nThreads, size * (thread + 1) / nThreads);
+  };
+  auto threads = std::vector<std::thread>();
+  for (auto thread = size_t{1}; thread < nThreads; ++thread)
+    threads.emplace_back(Run, thread);
+  if (nThreads != 0)
+    Run(0);
+  for (auto &thread : threads)
+    thread.join();
+  return results;
+}
+
+// Calls f(i) for every i in [0, size) on all hardware threads
+template <typename F> static void _ParallelFor(size_t size, F const &f) {
+  _ParallelChunks(size, [&](size_t first, size_t last) {
+    for (auto i = first; i != last; ++i)
+      f(i);
+    return last - first;
+  });
+}
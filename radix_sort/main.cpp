@@ -0,0 +1,59 @@
+#include <limits>
+
+#include "radix_sort.hpp"
+#include "../utils.hpp"
+
+// Signed values of both signs, with 64-bit keys using all of their bits
+template <typename K>
+static std::vector<K> ToKeys(std::vector<cl::sycl::cl_int> const &vec) {
+  auto keys = std::vector<K>(vec.size());
+  for (auto i = size_t{0}; i != vec.size(); ++i) {
+    auto value = static_cast<cl::sycl::cl_long>(vec[i]) -
+                 std::numeric_limits<cl::sycl::cl_int>::max() / 2;
+    if constexpr (sizeof(K) == 8)
+      value = value * vec[(i + 1) % vec.size()];
+    keys[i] = static_cast<K>(value) / static_cast<K>(3);
+  }
+  return keys;
+}
+
+template <typename K>
+static void CheckKeys(cl::sycl::queue &queue, BenchmarkOptions const &options,
+                      std::vector<K> const &keys,
+                      std::string_view description) {
+  std::cout << description << " keys" << std::endl;
+  Check(
+      options, keys, "CPU", [&](auto &v) { std::sort(v.begin(), v.end()); },
+      "GPU radix", [&](auto &v) { RadixSort(queue, v); });
+}
+
+int main(int argc, char *argv[]) {
+  using namespace cl::sycl;
+  auto pow = GetIntArgument(argc, argv, 12);
+  auto size = size_t{1} << pow;
+  auto options = GetBenchmarkOptions(argc, argv);
+  auto distributions = GetDistributions(argc, argv);
+  std::cout << "Random seed: " << RandomSeed() << std::endl;
+
+  for (auto const &device : GetDevices(argc, argv)) {
+    auto queue = cl::sycl::queue{device};
+    options.device = device.get_info<info::device::name>();
+    PrintInfo(queue, std::cout);
+
+    PrebuildKernels(queue, RadixSortKernels<cl_int>{},
+                    RadixSortKernels<cl_uint>{}, RadixSortKernels<cl_float>{},
+                    RadixSortKernels<cl_long>{}, RadixSortKernels<cl_ulong>{},
+                    RadixSortKernels<cl_double>{});
+
+    for (auto distribution : distributions) {
+      options.distribution = ToString(distribution);
+      auto vec = GetRandomVector(size, distribution);
+      CheckKeys(queue, options, vec, "cl_int");
+      CheckKeys(queue, options, ToKeys<cl_uint>(vec), "cl_uint");
+      CheckKeys(queue, options, ToKeys<cl_float>(vec), "cl_float");
+      CheckKeys(queue, options, ToKeys<cl_long>(vec), "cl_long");
+      CheckKeys(queue, options, ToKeys<cl_ulong>(vec), "cl_ulong");
+      CheckKeys(queue, options, ToKeys<cl_double>(vec), "cl_double");
+    }
+  }
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+
+#include "../utils.hpp"
+
+template <typename K, typename Index> class RadixHistogramKernel;
+template <typename K, typename Index> class RadixReduceKernel;
+template <typename K, typename Index> class RadixScanKernel;
+template <typename K, typename Index> class RadixDownsweepKernel;
+template <typename K, typename Index> class RadixScatterKernel;
+
+// Kernels of RadixSort, see PrebuildKernels
+template <typename K, typename Index = cl::sycl::cl_uint>
+using RadixSortKernels =
+    KernelList<RadixHistogramKernel<K, Index>, RadixReduceKernel<K, Index>,
+               RadixScanKernel<K, Index>, RadixDownsweepKernel<K, Index>,
+               RadixScatterKernel<K, Index>>;
+
+// Exclusive scan of local[0, n) by the n work items of g, called at work
+// group scope. Hillis-Steele steps alternate between both halves of local of
+// 2 * n elements, the returned offset is the one of the half with the result.
+template <typename Index, typename LocalAccess>
+static size_t _RadixScanLocal(cl::sycl::group<1> const &g,
+                              LocalAccess const &local, size_t n) {
+  using namespace cl::sycl;
+  auto in = size_t{0};
+  for (auto offset = size_t{1}; offset < n; offset *= 2) {
+    auto out = n - in;
+    g.parallel_for_work_item([=](h_item<1> it) {
+      auto i = it.get_local_id()[0];
+      local[out + i] =
+          local[in + i] + (i >= offset ? local[in + i - offset] : Index{0});
+    });
+    in = out;
+  }
+  auto out = n - in;
+  g.parallel_for_work_item([=](h_item<1> it) {
+    auto i = it.get_local_id()[0];
+    local[out + i] = i == 0 ? Index{0} : local[in + i - 1];
+  });
+  return out;
+}
+
+// Exclusive scan of data[start, end) in place plus offset by the work items
+// of g, called at work group scope: sums of chunks of chunkSize elements are
+// scanned in local memory, then every work item scans its own chunk
+template <typename Index, typename Data, typename LocalAccess>
+static void _RadixScanChunks(cl::sycl::group<1> const &g, Data const &data,
+                             size_t start, size_t end, size_t chunkSize,
+                             LocalAccess const &local, Index offset) {
+  using namespace cl::sycl;
+  g.parallel_for_work_item([=](h_item<1> it) {
+    auto chunkStart = std::min(start + it.get_local_id()[0] * chunkSize, end);
+    auto chunkEnd = std::min(chunkStart + chunkSize, end);
+    auto sum = Index{0};
+    for (auto i = chunkStart; i < chunkEnd; ++i)
+      sum += data[i];
+    local[it.get_local_id()[0]] = sum;
+  });
+  auto scanned = _RadixScanLocal<Index>(g, local, g.get_local_range(0));
+  g.parallel_for_work_item([=](h_item<1> it) {
+    auto chunkStart = std::min(start + it.get_local_id()[0] * chunkSize, end);
+    auto chunkEnd = std::min(chunkStart + chunkSize, end);
+    auto sum = offset + local[scanned + it.get_local_id()[0]];
+    for (auto i = chunkStart; i < chunkEnd; ++i) {
+      auto value = data[i];
+      data[i] = sum;
+      sum += value;
+    }
+  });
+}
+
+// LSD radix sort of 32-bit and 64-bit integer and floating point keys
+// Every pass sorts by RadixBits bits of the key in three kernels:
+// 1. Each work group counts digits of its tile of elements
+// 2. Exclusive scan of the counts stored digit-major gives for every
+//    (digit, work group) pair the position of its first element in the output.
+//    The scan is device-wide: blocks of counters are reduced, the sums of
+//    blocks are scanned by one work group, and every block is scanned from
+//    the sum of the blocks before it.
+// 3. Each work group recounts digits per work item, so every element gets
+//    its position in the input order, and scatters the elements
+// Every work item handles a contiguous chunk of elements, which makes the
+// scatter stable.
+// Counters and positions are of Index type, see WithIndexType
+template <typename K, typename Index>
+static void _RadixSort(cl::sycl::queue &queue, std::vector<K> &vec) {
+  using namespace cl::sycl;
+  using LocalAccess =
+      accessor<Index, 1, access::mode::read_write, access::target::local>;
+  auto constexpr RadixBits = 4;
+  auto constexpr Radix = 1 << RadixBits;
+  auto constexpr nPasses = static_cast<int>(sizeof(K) * 8 / RadixBits);
+  static_assert(nPasses % 2 == 0, "Result must end up in the input buffer");
+  auto size = vec.size();
+  if (size <= 1)
+    return;
+
+  // Local memory holds a counter per digit per work item
+  auto workGroupSizeRaw =
+      queue.get_device().get_info<info::device::max_work_group_size>();
+  auto localMem = queue.get_device().get_info<info::device::local_mem_size>();
+  auto WGSize = ClosestPowerOf2(std::min<size_t>(
+      workGroupSizeRaw, localMem / (Radix * sizeof(Index)) / 2));
+  auto nElementsPerWorkItem = size_t{16};
+  WGSize = std::min(WGSize, NextPowerOf2((size + nElementsPerWorkItem - 1) /
+                                         nElementsPerWorkItem));
+  auto WGElements = WGSize * nElementsPerWorkItem;
+  auto nWorkGroups = (size + WGElements - 1) / WGElements;
+  auto nCounters = Radix * nWorkGroups;
+  // Blocks of the scan have nScanElementsPerWorkItem counters per work item
+  auto scanWGSize = std::min(ClosestPowerOf2(workGroupSizeRaw),
+                             ClosestPowerOf2(localMem / (2 * sizeof(Index))));
+  auto constexpr nScanElementsPerWorkItem = size_t{16};
+  auto scanBlockSize = scanWGSize * nScanElementsPerWorkItem;
+  auto nScanBlocks = (nCounters + scanBlockSize - 1) / scanBlockSize;
+
+  auto buf = buffer{vec};
+  auto scratch = buffer<K, 1>{range<1>{size}};
+  auto counters = buffer<Index, 1>{range<1>{nCounters}};
+  auto blockSums = buffer<Index, 1>{range<1>{nScanBlocks}};
+
+  auto *input = &buf;
+  auto *output = &scratch;
+  for (auto pass = 0; pass != nPasses; ++pass) {
+    auto shift = pass * RadixBits;
+    auto Digit = [shift](K key) {
+      return static_cast<int>((ToOrderedBits(key) >> shift) & (Radix - 1));
+    };
+
+    queue.submit([&](handler &h) {
+      auto in = input->template get_access<access::mode::read>(h);
+      auto count = counters.template get_access<access::mode::discard_write>(h);
+      auto local = LocalAccess(range<1>{Radix * WGSize}, h);
+      h.parallel_for_work_group<RadixHistogramKernel<K, Index>>(
+          range<1>{nWorkGroups}, range<1>{WGSize}, [=](group<1> g) {
+            auto groupId = g.get_id(0);
+            auto startIndex = groupId * WGElements;
+            g.parallel_for_work_item([=](h_item<1> it) {
+              auto localId = it.get_local_id()[0];
+              cl_uint digitCount[Radix] = {};
+              auto start = startIndex + localId * nElementsPerWorkItem;
+              auto end = std::min(start + nElementsPerWorkItem, size);
+              for (auto i = start; i < end; ++i)
+                ++digitCount[Digit(in[i])];
+              for (auto d = 0; d != Radix; ++d)
+                local[d * WGSize + localId] = digitCount[d];
+            });
+            g.parallel_for_work_item([=](h_item<1> it) {
+              for (auto d = it.get_local_id()[0]; d < Radix; d += WGSize) {
+                auto sum = Index{0};
+                for (auto i = size_t{0}; i != WGSize; ++i)
+                  sum += local[d * WGSize + i];
+                count[d * nWorkGroups + groupId] = sum;
+              }
+            });
+          });
+    });
+
+    queue.submit([&](handler &h) {
+      auto count = counters.template get_access<access::mode::read>(h);
+      auto sums = blockSums.template get_access<access::mode::discard_write>(h);
+      auto local = LocalAccess(range<1>{scanWGSize}, h);
+      h.parallel_for_work_group<RadixReduceKernel<K, Index>>(
+          range<1>{nScanBlocks}, range<1>{scanWGSize}, [=](group<1> g) {
+            auto blockStart = g.get_id(0) * scanBlockSize;
+            g.parallel_for_work_item([=](h_item<1> it) {
+              auto localId = it.get_local_id()[0];
+              auto start = std::min(
+                  blockStart + localId * nScanElementsPerWorkItem, nCounters);
+              auto end = std::min(start + nScanElementsPerWorkItem, nCounters);
+              auto sum = Index{0};
+              for (auto i = start; i < end; ++i)
+                sum += count[i];
+              local[localId] = sum;
+            });
+            for (auto stride = scanWGSize / 2; stride != 0; stride /= 2)
+              g.parallel_for_work_item([=](h_item<1> it) {
+                auto localId = it.get_local_id()[0];
+                if (localId < stride)
+                  local[localId] += local[localId + stride];
+              });
+            g.parallel_for_work_item([=](h_item<1> it) {
+              if (it.get_local_id()[0] == 0)
+                sums[g.get_id(0)] = local[0];
+            });
+          });
+    });
+
+    // Sums of blocks are few enough for one work group
+    queue.submit([&](handler &h) {
+      auto sums = blockSums.template get_access<access::mode::read_write>(h);
+      auto local = LocalAccess(range<1>{2 * scanWGSize}, h);
+      auto chunkSize = (nScanBlocks + scanWGSize - 1) / scanWGSize;
+      h.parallel_for_work_group<RadixScanKernel<K, Index>>(
+          range<1>{1}, range<1>{scanWGSize}, [=](group<1> g) {
+            _RadixScanChunks(g, sums, 0, nScanBlocks, chunkSize, local,
+                             Index{0});
+          });
+    });
+
+    queue.submit([&](handler &h) {
+      auto count = counters.template get_access<access::mode::read_write>(h);
+      auto sums = blockSums.template get_access<access::mode::read>(h);
+      auto local = LocalAccess(range<1>{2 * scanWGSize}, h);
+      h.parallel_for_work_group<RadixDownsweepKernel<K, Index>>(
+          range<1>{nScanBlocks}, range<1>{scanWGSize}, [=](group<1> g) {
+            auto blockStart = g.get_id(0) * scanBlockSize;
+            _RadixScanChunks(g, count, blockStart,
+                             std::min(blockStart + scanBlockSize, nCounters),
+                             nScanElementsPerWorkItem, local,
+                             Index{sums[g.get_id(0)]});
+          });
+    });
+
+    queue.submit([&](handler &h) {
+      auto in = input->template get_access<access::mode::read>(h);
+      auto out = output->template get_access<access::mode::discard_write>(h);
+      auto count = counters.template get_access<access::mode::read>(h);
+      auto local = LocalAccess(range<1>{Radix * WGSize}, h);
+      h.parallel_for_work_group<RadixScatterKernel<K, Index>>(
+          range<1>{nWorkGroups}, range<1>{WGSize}, [=](group<1> g) {
+            auto groupId = g.get_id(0);
+            auto startIndex = groupId * WGElements;
+            g.parallel_for_work_item([=](h_item<1> it) {
+              auto localId = it.get_local_id()[0];
+              cl_uint digitCount[Radix] = {};
+              auto start = startIndex + localId * nElementsPerWorkItem;
+              auto end = std::min(start + nElementsPerWorkItem, size);
+              for (auto i = start; i < end; ++i)
+                ++digitCount[Digit(in[i])];
+              for (auto d = 0; d != Radix; ++d)
+                local[d * WGSize + localId] = digitCount[d];
+            });
+            // Position of the first element of each work item for each digit
+            g.parallel_for_work_item([=](h_item<1> it) {
+              for (auto d = it.get_local_id()[0]; d < Radix; d += WGSize) {
+                auto sum = count[d * nWorkGroups + groupId];
+                for (auto i = size_t{0}; i != WGSize; ++i) {
+                  auto value = local[d * WGSize + i];
+                  local[d * WGSize + i] = sum;
+                  sum += value;
+                }
+              }
+            });
+            g.parallel_for_work_item([=](h_item<1> it) {
+              auto localId = it.get_local_id()[0];
+              Index position[Radix];
+              for (auto d = 0; d != Radix; ++d)
+                position[d] = local[d * WGSize + localId];
+              auto start = startIndex + localId * nElementsPerWorkItem;
+              auto end = std::min(start + nElementsPerWorkItem, size);
+              for (auto i = start; i < end; ++i) {
+                auto key = in[i];
+                out[position[Digit(key)]++] = key;
+              }
+            });
+          });
+    });
+    std::swap(input, output);
+  }
+
+  queue.wait();
+  buf.template get_access<access::mode::read_write>();
+}
+
+template <typename K>
+static void RadixSort(cl::sycl::queue &queue, std::vector<K> &vec) {
+  WithIndexType(vec.size(), [&](auto index) {
+    _RadixSort<K, decltype(index)>(queue, vec);
+  });
+}
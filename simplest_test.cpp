@@ -1,12 +1,13 @@
 #include <CL/sycl.hpp>
 
-int main() {
+#include "utils.hpp"
+
+int main(int argc, char *argv[]) {
   using namespace cl::sycl;
   auto size = size_t{16};
   auto vec = std::vector<int>(size);
 
-  auto GPUSelector = gpu_selector{};
-  auto q = queue{GPUSelector};
+  auto q = queue{GetDevice(argc, argv)};
   auto buf = buffer{vec};
     
   q.submit([&](handler &h) {
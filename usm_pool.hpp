@@ -0,0 +1,163 @@
+#pragma once
+
+#include <CL/sycl.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Pool of USM allocations of a queue, device, shared or host ones
+// Sizes are rounded up to powers of two, and freed blocks are kept in a free
+// list per kind and size class, so repeated runs of the same sizes allocate
+// only on the first run. Blocks are freed in stream order: Free takes the
+// events of the commands still using the block, and it is reused only after
+// they complete, so the caller never waits for them.
+class UsmPool {
+public:
+  struct Stats {
+    // Allocations served from a free list and by the runtime
+    size_t nHits = 0;
+    size_t nMisses = 0;
+    size_t nBytesReserved = 0;
+    // Largest nBytesReserved, Trim lowers the current one only
+    size_t maxBytesReserved = 0;
+  };
+
+  explicit UsmPool(cl::sycl::queue const &queue) : queue(queue) {}
+
+  // Pending blocks may still be in use by the device
+  ~UsmPool() {
+    for (auto &pending : pendingBlocks)
+      cl::sycl::event::wait(pending.events);
+    for (auto const &[block, info] : blocks)
+      cl::sycl::free(block, queue);
+  }
+
+  UsmPool(UsmPool const &) = delete;
+  UsmPool &operator=(UsmPool const &) = delete;
+
+  template <typename T>
+  T *Allocate(size_t n,
+              cl::sycl::usm::alloc kind = cl::sycl::usm::alloc::device) {
+    return static_cast<T *>(AllocateBytes(n * sizeof(T), kind));
+  }
+
+  void *AllocateBytes(size_t nBytes, cl::sycl::usm::alloc kind) {
+    auto constexpr minSizeClass = size_t{256};
+    auto sizeClass = minSizeClass;
+    while (sizeClass < nBytes)
+      sizeClass *= 2;
+    auto lock = std::lock_guard{mutex};
+    _ReclaimCompleted();
+    auto &freeList = freeBlocks[{kind, sizeClass}];
+    if (!freeList.empty()) {
+      auto *block = freeList.back();
+      freeList.pop_back();
+      ++stats.nHits;
+      return block;
+    }
+    auto *block = cl::sycl::malloc(sizeClass, queue, kind);
+    if (!block)
+      throw std::bad_alloc{};
+    blocks[block] = {kind, sizeClass};
+    ++stats.nMisses;
+    stats.nBytesReserved += sizeClass;
+    stats.maxBytesReserved =
+        std::max(stats.maxBytesReserved, stats.nBytesReserved);
+    return block;
+  }
+
+  // Block returns to its free list once all events complete
+  void Free(void *block, std::vector<cl::sycl::event> events = {}) {
+    if (!block)
+      return;
+    auto lock = std::lock_guard{mutex};
+    assert(blocks.count(block) != 0);
+    pendingBlocks.push_back({block, std::move(events)});
+    _ReclaimCompleted();
+  }
+
+  // Returns the blocks of the free lists to the runtime, blocks still in use
+  // or pending are kept. Called between workloads of different sizes, so
+  // size classes of earlier ones are not held forever.
+  void Trim() {
+    auto lock = std::lock_guard{mutex};
+    _ReclaimCompleted();
+    for (auto &[sizeClass, freeList] : freeBlocks) {
+      for (auto *block : freeList) {
+        cl::sycl::free(block, queue);
+        blocks.erase(block);
+        stats.nBytesReserved -= sizeClass.second;
+      }
+    }
+    freeBlocks.clear();
+  }
+
+  // Memory of the pool may be used on any queue of this context
+  cl::sycl::context GetContext() const { return queue.get_context(); }
+
+  Stats GetStats() const {
+    auto lock = std::lock_guard{mutex};
+    return stats;
+  }
+
+private:
+  struct PendingBlock {
+    void *block;
+    std::vector<cl::sycl::event> events;
+  };
+
+  static bool _IsComplete(std::vector<cl::sycl::event> const &events) {
+    using namespace cl::sycl;
+    return std::all_of(events.begin(), events.end(), [](event const &e) {
+      return e.get_info<info::event::command_execution_status>() ==
+             info::event_command_status::complete;
+    });
+  }
+
+  void _ReclaimCompleted() {
+    auto completed = std::stable_partition(
+        pendingBlocks.begin(), pendingBlocks.end(),
+        [](PendingBlock const &pending) {
+          return !_IsComplete(pending.events);
+        });
+    for (auto it = completed; it != pendingBlocks.end(); ++it)
+      freeBlocks[blocks.at(it->block)].push_back(it->block);
+    pendingBlocks.erase(completed, pendingBlocks.end());
+  }
+
+  using SizeClass = std::pair<cl::sycl::usm::alloc, size_t>;
+
+  cl::sycl::queue queue;
+  mutable std::mutex mutex;
+  // Kind and size class of every block allocated from the runtime
+  std::unordered_map<void *, SizeClass> blocks;
+  std::map<SizeClass, std::vector<void *>> freeBlocks;
+  std::vector<PendingBlock> pendingBlocks;
+  Stats stats;
+};
+
+// Device memory from pool, or from the runtime without one
+template <typename T>
+static T *UsmAllocate(cl::sycl::queue &queue, UsmPool *pool, size_t n) {
+  assert(!pool || pool->GetContext() == queue.get_context());
+  return pool ? pool->Allocate<T>(n) : cl::sycl::malloc_device<T>(n, queue);
+}
+
+// Frees memory of UsmAllocate once events complete, without a pool it waits
+// for them
+static void UsmFree(cl::sycl::queue &queue, UsmPool *pool, void *block,
+                    std::vector<cl::sycl::event> events = {}) {
+  assert(!pool || pool->GetContext() == queue.get_context());
+  if (pool) {
+    pool->Free(block, std::move(events));
+    return;
+  }
+  cl::sycl::event::wait(events);
+  cl::sycl::free(block, queue);
+}
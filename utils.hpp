@@ -1,32 +1,107 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <numeric>
 #include <random>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <vector>
 
 #include <CL/sycl.hpp>
 
 #include <utility/misc.hpp>
 
+#include "distributions.hpp"
+#include "parallel.hpp"
+#include "usm_pool.hpp"
+
+static bool _IsOption(std::string_view arg) { return arg.substr(0, 2) == "--"; }
+
+// nArg-th positional argument, options are skipped
 static int GetIntArgument(int argc, char *argv[], int defaultValue = 0,
                           size_t nArg = 0) {
-  auto index = nArg + 1;
-  if (argc <= index)
-    return defaultValue;
-  auto arg = std::string(argv[index]);
-  return std::stoi(arg);
+  for (auto i = 1; i < argc; ++i) {
+    if (_IsOption(argv[i]))
+      continue;
+    if (nArg-- == 0)
+      return std::stoi(std::string(argv[i]));
+  }
+  return defaultValue;
 }
 
-static std::vector<cl::sycl::cl_int> GetRandomVector(size_t size) {
-  auto rd = std::random_device{};
-  auto gen = std::mt19937{static_cast<unsigned>(rd())};
-  auto vec = std::vector<cl::sycl::cl_int>(size);
-  auto rand = std::uniform_int_distribution<>();
-  for (auto i = size_t{0}; i < size; ++i)
-    vec[i] = rand(gen);
-  return vec;
+// Value of "--name=value" option, "--name" alone is the same as "--name=1"
+static std::string GetOption(int argc, char *argv[], std::string_view name,
+                             std::string const &defaultValue = "") {
+  for (auto i = 1; i < argc; ++i) {
+    auto arg = std::string_view(argv[i]);
+    if (_IsOption(arg) && arg.substr(2) == name)
+      return "1";
+    if (_IsOption(arg) && arg.substr(2, name.size()) == name &&
+        arg.substr(name.size() + 2, 1) == "=")
+      return std::string(arg.substr(name.size() + 3));
+  }
+  return defaultValue;
+}
+
+// Seed of all random vectors of the run, random unless set with --seed
+static std::uint64_t &RandomSeed() {
+  static auto seed = []() {
+    auto rd = std::random_device{};
+    return (std::uint64_t{rd()} << 32) | rd();
+  }();
+  return seed;
+}
+
+// Every vector is a separate stream of the seed, so the seed reproduces a run
+static std::uint64_t _NextRandomStream() {
+  static auto nStreams = std::atomic<std::uint64_t>{0};
+  return nStreams++;
+}
+
+// See GenerateVector for the distributions, integers are uniform over the
+// whole range of T and floating point values over [-size, size] by default
+template <typename T = cl::sycl::cl_int>
+static std::vector<T>
+GetRandomVector(size_t size,
+                Distribution distribution = Distribution::Uniform) {
+  return GenerateVector<T>(size, distribution, RandomSeed(),
+                           _NextRandomStream());
+}
+
+// --distribution=name[,name...] or all, uniform by default
+static std::vector<Distribution> GetDistributions(int argc, char *argv[]) {
+  return ParseDistributions(GetOption(argc, argv, "distribution", "uniform"));
+}
+
+// Overwrites some elements with NaNs of both signs, infinities, zeros of both
+// signs and the smallest denormals
+template <typename T> static void AddSpecialValues(std::vector<T> &vec) {
+  static_assert(std::is_floating_point_v<T>);
+  using limits = std::numeric_limits<T>;
+  auto specials = {limits::quiet_NaN(),   -limits::quiet_NaN(),
+                   limits::infinity(),    -limits::infinity(),
+                   T{0},                  -T{0},
+                   limits::denorm_min(), -limits::denorm_min()};
+  auto step = std::max<size_t>(vec.size() / specials.size(), 1);
+  auto i = size_t{0};
+  for (auto special : specials) {
+    if (i >= vec.size())
+      break;
+    vec[i] = special;
+    i += step;
+  }
 }
 
 static std::string ToString(cl::sycl::info::device_type deviceType) {
@@ -36,6 +111,8 @@ static std::string ToString(cl::sycl::info::device_type deviceType) {
     return "cpu";
   case info::device_type::gpu:
     return "gpu";
+  case info::device_type::host:
+    return "host";
   case info::device_type::accelerator:
     return "accelerator";
   case info::device_type::all:
@@ -45,10 +122,56 @@ static std::string ToString(cl::sycl::info::device_type deviceType) {
   }
 }
 
+// Spec is "cpu", "gpu", "host", "accelerator", "all" or a part of the name
+static bool _MatchesDevice(cl::sycl::device const &device,
+                           std::string const &spec) {
+  using namespace cl::sycl;
+  if (spec == "all")
+    return true;
+  if (spec == "cpu" || spec == "gpu" || spec == "host" ||
+      spec == "accelerator")
+    return ToString(device.get_info<info::device::device_type>()) == spec;
+  auto ToLower = [](std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return text;
+  };
+  return ToLower(device.get_info<info::device::name>())
+             .find(ToLower(spec)) != std::string::npos;
+}
+
+// Devices given by --device=spec option or SYCL_EXPERIMENTS_DEVICE
+// environment variable, see _MatchesDevice. GPU is the default.
+static std::vector<cl::sycl::device> GetDevices(int argc, char *argv[]) {
+  using namespace cl::sycl;
+  auto spec = GetOption(argc, argv, "device");
+  if (auto *env = std::getenv("SYCL_EXPERIMENTS_DEVICE"); spec.empty() && env)
+    spec = env;
+  if (spec.empty())
+    spec = "gpu";
+  auto devices = std::vector<device>();
+  for (auto const &candidate : device::get_devices())
+    if (_MatchesDevice(candidate, spec))
+      devices.push_back(candidate);
+  // Host device is not listed by some implementations
+  if (devices.empty() && spec == "host")
+    devices.push_back(host_selector{}.select_device());
+  if (devices.empty())
+    throw std::runtime_error{"No device matches \"" + spec + "\""};
+  return devices;
+}
+
+// The first of GetDevices
+static cl::sycl::device GetDevice(int argc, char *argv[]) {
+  return GetDevices(argc, argv).front();
+}
+
 static void PrintInfo(cl::sycl::queue const &queue, std::ostream &os) {
   using namespace cl::sycl;
   auto device = queue.get_device();
-  os << device.get_info<info::device::name>() << std::endl;
+  os << device.get_info<info::device::name>() << " ("
+     << ToString(device.get_info<info::device::device_type>()) << ")"
+     << std::endl;
   os << "Driver version: " << device.get_info<info::device::driver_version>()
      << std::endl;
   os << "Compute units: " << device.get_info<info::device::max_compute_units>()
@@ -79,43 +202,365 @@ static void PrintInfo(cl::sycl::queue const &queue, std::ostream &os) {
   os << std::endl;
 }
 
-static void WarmUp(cl::sycl::queue &queue) {
-  auto time = Utility::Benchmark([&]() {
-    auto x = std::vector<cl::sycl::cl_int>(8);
-    auto buf = cl::sycl::buffer{x};
-    auto range1d = cl::sycl::range<1>{buf.get_count()};
-    queue.submit([&](cl::sycl::handler &h) {
-      auto access =
-          buf.template get_access<cl::sycl::access::mode::read_write>(h);
-      h.parallel_for<class WarmUpKernel>(
-          range1d, [access](cl::sycl::id<1> id) { access[id[0]] = id[0]; });
-    });
+// Kernel names, see PrebuildKernels
+template <typename... Kernels> struct KernelList {};
+
+template <typename... Kernels>
+static void _BuildKernels(cl::sycl::context const &context,
+                          KernelList<Kernels...>) {
+  // A program can be built once, so every kernel gets its own
+  (cl::sycl::program{context}.template build_with_kernel_type<Kernels>(),
+   ...);
+}
+
+// Builds the device images of the kernels at start-up, so their first
+// submission on a queue of the same context does not pay JIT compilation.
+// Built images are kept in the program cache of the context. Images compiled
+// ahead of time (e.g. -fsycl-targets=spir64_x86_64 for CPUs) are only loaded.
+template <typename... Lists>
+static void PrebuildKernels(cl::sycl::queue &queue, Lists... lists) {
+  auto time = Utility::Benchmark(
+      [&]() { (_BuildKernels(queue.get_context(), lists), ...); });
+  std::cout << "Kernel build time: " << (time.count() / 1000)
+            << " microseconds" << std::endl;
+}
+
+// Unsigned integer of the same size as T
+template <typename T>
+using OrderedBitsType =
+    std::conditional_t<sizeof(T) == sizeof(cl::sycl::cl_ulong),
+                       cl::sycl::cl_ulong, cl::sycl::cl_uint>;
+
+// Maps 32-bit or 64-bit key to unsigned integer with the same order
+template <typename K> static OrderedBitsType<K> ToOrderedBits(K key) {
+  using Bits = OrderedBitsType<K>;
+  static_assert(sizeof(K) == sizeof(Bits),
+                "Only 32-bit and 64-bit keys are supported");
+  auto bits = Bits{};
+  std::memcpy(&bits, &key, sizeof(K));
+  auto constexpr signBit = Bits{1} << (sizeof(Bits) * 8 - 1);
+  if constexpr (std::is_floating_point_v<K>)
+    // Negative values are ordered backwards and go before positive ones
+    return bits ^ ((bits & signBit) ? ~Bits{0} : signBit);
+  else if constexpr (std::is_signed_v<K>)
+    return bits ^ signBit;
+  else
+    return bits;
+}
+
+template <typename K> static K FromOrderedBits(OrderedBitsType<K> bits) {
+  using Bits = OrderedBitsType<K>;
+  auto constexpr signBit = Bits{1} << (sizeof(Bits) * 8 - 1);
+  if constexpr (std::is_floating_point_v<K>)
+    bits ^= (bits & signBit) ? signBit : ~Bits{0};
+  else if constexpr (std::is_signed_v<K>)
+    bits ^= signBit;
+  auto key = K{};
+  std::memcpy(&key, &bits, sizeof(K));
+  return key;
+}
+
+// Comparators of the sorts, they are function objects since device code
+// cannot call through pointers. Results are deduced, so the same comparator
+// works for ESIMD vectors.
+struct Less {
+  template <typename T> auto operator()(T const &lhs, T const &rhs) const {
+    return lhs < rhs;
+  }
+};
+
+struct Greater {
+  template <typename T> auto operator()(T const &lhs, T const &rhs) const {
+    return rhs < lhs;
+  }
+};
+
+// Total order of IEEE 754 for floating point values:
+// -NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN
+// The same as Less for integers
+struct TotalOrderLess {
+  template <typename T> auto operator()(T const &lhs, T const &rhs) const {
+    if constexpr (std::is_floating_point_v<T>)
+      return ToOrderedBits(lhs) < ToOrderedBits(rhs);
+    else
+      return lhs < rhs;
+  }
+};
+
+struct TotalOrderGreater {
+  template <typename T> auto operator()(T const &lhs, T const &rhs) const {
+    return TotalOrderLess{}(rhs, lhs);
+  }
+};
+
+// Compares projections of elements, e.g. a field of a record
+// Projection is a named function object type, it is a part of kernel names
+template <typename Projection, typename Compare = Less> struct CompareBy {
+  Projection projection;
+  Compare compare;
+
+  template <typename T> bool operator()(T const &lhs, T const &rhs) const {
+    return compare(projection(lhs), projection(rhs));
+  }
+};
+
+template <typename Projection, typename Compare = Less>
+CompareBy(Projection, Compare = {}) -> CompareBy<Projection, Compare>;
+
+// Floating point values are equal when their bits are, so that NaNs match
+template <typename T> static bool _Equal(T const &lhs, T const &rhs) {
+  if constexpr (std::is_floating_point_v<T>)
+    return ToOrderedBits(lhs) == ToOrderedBits(rhs);
+  else
+    return lhs == rhs;
+}
+
+// Returns event that completes when all of the events complete
+static cl::sycl::event JoinEvents(cl::sycl::queue &queue,
+                                  std::vector<cl::sycl::event> const &events) {
+  if (events.size() == 1)
+    return events.front();
+  return queue.submit([&](cl::sycl::handler &h) {
+    h.depends_on(events);
+    h.single_task<class JoinEventsKernel>([]() {});
   });
-  std::cout << "GPU warm up time: " << (time.count() / 1000) << " microseconds"
-            << std::endl;
 }
 
+// Exact comparison with the result of the first competitor, or sortedness and
+// a multiset hash of the input, which keeps no reference result in memory
+enum class Verification { Exact, Hash };
+
+struct BenchmarkOptions {
+  // Untimed runs of every competitor, e.g. to JIT compile its kernels
+  size_t nWarmups = 0;
+  size_t nRepeats = 1;
+  // Name of the device the benchmarks run on, distribution of the input and
+  // memory access pattern of the kernel if any, reported with the results
+  std::string device;
+  std::string distribution = ToString(Distribution::Uniform);
+  std::string pattern;
+  Verification verification = Verification::Hash;
+  // Optional machine-readable reports with a line per competitor and size
+  std::shared_ptr<std::ostream> csv;
+  std::shared_ptr<std::ostream> json;
+};
+
+// Options are --warmups=N, --repeats=N, --csv=path, --json=path, --seed=N and
+// --verify=hash|exact
+static BenchmarkOptions GetBenchmarkOptions(int argc, char *argv[]) {
+  auto options = BenchmarkOptions{};
+  auto verification = GetOption(argc, argv, "verify", "hash");
+  if (verification != "hash" && verification != "exact")
+    throw std::runtime_error{"Unknown verification \"" + verification + "\""};
+  if (verification == "exact")
+    options.verification = Verification::Exact;
+  if (auto seed = GetOption(argc, argv, "seed"); !seed.empty())
+    RandomSeed() = std::stoull(seed);
+  options.nWarmups = std::stoul(GetOption(argc, argv, "warmups", "0"));
+  options.nRepeats =
+      std::max<size_t>(1, std::stoul(GetOption(argc, argv, "repeats", "1")));
+  if (auto path = GetOption(argc, argv, "csv"); !path.empty()) {
+    options.csv = std::make_shared<std::ofstream>(path);
+    *options.csv << "device,distribution,pattern,name,size,repeats,min_us,"
+                    "median_us,p90_us,p99_us,elements_per_second"
+                 << std::endl;
+  }
+  // JSON Lines, an object per line
+  if (auto path = GetOption(argc, argv, "json"); !path.empty())
+    options.json = std::make_shared<std::ofstream>(path);
+  return options;
+}
+
+struct BenchmarkStats {
+  std::chrono::nanoseconds min{0};
+  std::chrono::nanoseconds median{0};
+  std::chrono::nanoseconds p90{0};
+  std::chrono::nanoseconds p99{0};
+  // Computed from the median time
+  double elementsPerSecond = 0;
+};
+
+static BenchmarkStats GetStats(std::vector<std::chrono::nanoseconds> times,
+                               size_t nElements) {
+  assert(!times.empty());
+  std::sort(times.begin(), times.end());
+  // Nearest-rank percentile
+  auto Percentile = [&](size_t percent) {
+    auto rank = (percent * times.size() + 99) / 100;
+    return times[std::max<size_t>(rank, 1) - 1];
+  };
+  auto stats = BenchmarkStats{times.front(), Percentile(50), Percentile(90),
+                              Percentile(99)};
+  auto seconds = std::chrono::duration<double>(stats.median).count();
+  stats.elementsPerSecond = seconds == 0 ? 0 : nElements / seconds;
+  return stats;
+}
+
+// Wraps text in double quotes, escaping quotes with the escape character
+static std::string _Quote(std::string_view text, char escape) {
+  auto result = std::string{"\""};
+  for (auto c : text) {
+    if (c == '"' || c == escape)
+      result += escape;
+    result += c;
+  }
+  return result + '"';
+}
+
+static void _ReportStats(BenchmarkOptions const &options,
+                         std::string_view description, size_t size,
+                         BenchmarkStats const &stats) {
+  auto Microseconds = [](std::chrono::nanoseconds time) {
+    return time.count() / 1000.0;
+  };
+  std::cout << description << " time: " << (stats.median.count() / 1000)
+            << " microseconds";
+  if (options.nRepeats > 1)
+    std::cout << " (median of " << options.nRepeats << " runs, min "
+              << (stats.min.count() / 1000) << ", p90 "
+              << (stats.p90.count() / 1000) << ", p99 "
+              << (stats.p99.count() / 1000) << "), "
+              << stats.elementsPerSecond << " elements per second";
+  std::cout << std::endl;
+
+  if (options.csv)
+    *options.csv << _Quote(options.device, '"') << ","
+                 << options.distribution << "," << options.pattern << ","
+                 << _Quote(description, '"') << "," << size << ","
+                 << options.nRepeats << "," << Microseconds(stats.min) << ","
+                 << Microseconds(stats.median) << ","
+                 << Microseconds(stats.p90) << "," << Microseconds(stats.p99)
+                 << "," << stats.elementsPerSecond << std::endl;
+  if (options.json)
+    *options.json << "{\"device\": " << _Quote(options.device, '\\')
+                  << ", \"distribution\": \"" << options.distribution << "\""
+                  << ", \"pattern\": \"" << options.pattern << "\""
+                  << ", \"name\": " << _Quote(description, '\\')
+                  << ", \"size\": " << size
+                  << ", \"repeats\": " << options.nRepeats
+                  << ", \"min_us\": " << Microseconds(stats.min)
+                  << ", \"median_us\": " << Microseconds(stats.median)
+                  << ", \"p90_us\": " << Microseconds(stats.p90)
+                  << ", \"p99_us\": " << Microseconds(stats.p99)
+                  << ", \"elements_per_second\": " << stats.elementsPerSecond
+                  << "}" << std::endl;
+}
+
+// Every run sorts a fresh copy of vec, result is the output of the last one
 template <typename T, typename Competitor>
-static void _RunCompetitor(std::vector<T> &vec, std::string_view description,
+static void _RunCompetitor(BenchmarkOptions const &options,
+                           std::vector<T> const &vec, std::vector<T> &result,
+                           std::string_view description,
                            Competitor &&competitor) {
-  auto time = Utility::Benchmark([&]() { competitor(vec); });
-  std::cout << description << " time: " << (time.count() / 1000)
-            << " microseconds" << std::endl;
+  using std::chrono::nanoseconds;
+  for (auto i = size_t{0}; i != options.nWarmups; ++i) {
+    result = vec;
+    competitor(result);
+  }
+  auto times = std::vector<nanoseconds>();
+  for (auto i = size_t{0}; i != options.nRepeats; ++i) {
+    result = vec;
+    times.push_back(std::chrono::duration_cast<nanoseconds>(
+        Utility::Benchmark([&]() { competitor(result); })));
+  }
+  _ReportStats(options, description, vec.size(),
+               GetStats(std::move(times), vec.size()));
+}
+
+// Mixing function of splitmix64
+static std::uint64_t _Mix(std::uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+  return x ^ (x >> 31);
+}
+
+// Hash of the elements independent of their order: sum of hashes of the
+// bytes of every element, so types with padding cannot be hashed
+template <typename T>
+static std::uint64_t MultisetHash(std::vector<T> const &vec) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  auto sums = _ParallelChunks(vec.size(), [&](size_t first, size_t last) {
+    auto sum = std::uint64_t{0};
+    for (auto i = first; i != last; ++i) {
+      auto const *bytes = reinterpret_cast<unsigned char const *>(&vec[i]);
+      auto hash = std::uint64_t{sizeof(T)};
+      for (auto offset = size_t{0}; offset < sizeof(T); offset += 8) {
+        auto word = std::uint64_t{0};
+        std::memcpy(&word, bytes + offset,
+                    std::min<size_t>(8, sizeof(T) - offset));
+        hash = _Mix(hash ^ word);
+      }
+      sum += hash;
+    }
+    return sum;
+  });
+  return std::accumulate(sums.begin(), sums.end(), std::uint64_t{0});
+}
+
+// Position of the first element going before the previous one, or the size
+template <typename T, typename Compare>
+static size_t _FindUnsorted(std::vector<T> const &vec, Compare compare) {
+  auto found = _ParallelChunks(vec.size(), [&](size_t first, size_t last) {
+    for (auto i = std::max<size_t>(first, 1); i < last; ++i)
+      if (compare(vec[i], vec[i - 1]))
+        return i;
+    return vec.size();
+  });
+  return found.empty() ? vec.size()
+                       : *std::min_element(found.begin(), found.end());
+}
+
+// Position of the first element differing between the vectors, or the size
+template <typename T>
+static size_t _FindMismatch(std::vector<T> const &lhs,
+                            std::vector<T> const &rhs) {
+  auto found = _ParallelChunks(lhs.size(), [&](size_t first, size_t last) {
+    for (auto i = first; i != last; ++i)
+      if (!_Equal(lhs[i], rhs[i]))
+        return i;
+    return lhs.size();
+  });
+  return found.empty() ? lhs.size()
+                       : *std::min_element(found.begin(), found.end());
+}
+
+template <typename T, typename Compare, typename Competitor,
+          typename... Competitors>
+static void _CheckHashed(BenchmarkOptions const &options,
+                         std::vector<T> const &vec, std::uint64_t hash,
+                         Compare compare, std::vector<T> &result,
+                         std::string_view description, Competitor &&competitor,
+                         Competitors &&... competitors) {
+  _RunCompetitor(options, vec, result, description, competitor);
+
+  if (auto i = _FindUnsorted(result, compare); i != result.size()) {
+    auto message = std::stringstream{};
+    message << std::endl;
+    message << "Result of \"" << description << "\" is not sorted at pos " << i
+            << std::endl;
+    message << "values: " << result[i - 1] << ", " << result[i] << std::endl;
+    throw std::runtime_error{message.str()};
+  }
+  if (MultisetHash(result) != hash)
+    throw std::runtime_error{"\nResult of \"" + std::string(description) +
+                             "\" is not a permutation of the input\n"};
+
+  if constexpr (sizeof...(competitors) > 0)
+    _CheckHashed(options, vec, hash, compare, result,
+                 std::forward<Competitors>(competitors)...);
 }
 
 template <typename T, typename Competitor, typename... Competitors>
 static void
-_Check(std::vector<T> const &previousResult, std::vector<T> const &vec,
-       std::string_view previousDescription, std::string_view description,
-       Competitor &&competitor, Competitors &&... competitors) {
-  auto size = vec.size();
-  auto result = vec;
+_Check(BenchmarkOptions const &options, std::vector<T> const &previousResult,
+       std::vector<T> const &vec, std::string_view previousDescription,
+       std::string_view description, Competitor &&competitor,
+       Competitors &&... competitors) {
+  auto result = std::vector<T>();
 
-  _RunCompetitor(result, description, competitor);
+  _RunCompetitor(options, vec, result, description, competitor);
 
-  for (auto i = size_t{0}; i < size; ++i) {
-    if (result[i] == previousResult[i])
-      continue;
+  if (auto i = _FindMismatch(result, previousResult); i != result.size()) {
     auto message = std::stringstream{};
     message << std::endl;
     message << "Results from \"" << previousDescription << "\"";
@@ -128,30 +573,87 @@ _Check(std::vector<T> const &previousResult, std::vector<T> const &vec,
   }
 
   if constexpr (sizeof...(competitors) > 0)
-    _Check(previousResult, vec, description,
+    _Check(options, previousResult, vec, description,
            std::forward<Competitors>(competitors)...);
 }
 
+// Runs every competitor, pairs of a description and a function sorting its
+// argument, on vec and verifies the results as options.verification says,
+// sortedness is in the order of compare
+template <typename T, typename Compare, typename Competitor,
+          typename... Competitors>
+static void CheckBy(BenchmarkOptions const &options, Compare compare,
+                    std::vector<T> const &vec, std::string_view description,
+                    Competitor &&competitor, Competitors &&... competitors) {
+  static_assert(sizeof...(competitors) % 2 == 0);
+  std::cout << "Running benchmark on vector of " << vec.size() << " "
+            << options.distribution << " elements..." << std::endl;
+
+  auto result = std::vector<T>();
+  if (options.verification == Verification::Hash) {
+    _CheckHashed(options, vec, MultisetHash(vec), compare, result, description,
+                 std::forward<Competitor>(competitor),
+                 std::forward<Competitors>(competitors)...);
+  } else {
+    _RunCompetitor(options, vec, result, description, competitor);
+    if constexpr (sizeof...(competitors) > 0)
+      _Check(options, result, vec, description,
+             std::forward<Competitors>(competitors)...);
+  }
+
+  std::cout << std::endl;
+}
+
+template <typename T, typename Competitor, typename... Competitors>
+static void Check(BenchmarkOptions const &options, std::vector<T> const &vec,
+                  std::string_view description, Competitor &&competitor,
+                  Competitors &&... competitors) {
+  CheckBy(options, Less{}, vec, description,
+          std::forward<Competitor>(competitor),
+          std::forward<Competitors>(competitors)...);
+}
+
+// Single run of every competitor without machine-readable output
 template <typename T, typename Competitor, typename... Competitors>
 static void Check(std::vector<T> const &vec, std::string_view description,
                   Competitor &&competitor, Competitors &&... competitors) {
-  static_assert(sizeof...(competitors) % 2 == 0);
-  std::cout << "Running benchmark on vector of " << vec.size() << " elements..."
-            << std::endl;
+  Check(BenchmarkOptions{}, vec, description,
+        std::forward<Competitor>(competitor),
+        std::forward<Competitors>(competitors)...);
+}
 
-  auto result = vec;
-  _RunCompetitor(result, description, competitor);
+// Times the start-up of every competitor, pairs of a description and a
+// function sorting its second argument on the queue given as the first one.
+// Cold start is the first run on a queue with a new context, which builds the
+// kernels unless they are compiled ahead of time, prebuilt start is the first
+// run on queue after PrebuildKernels and warm start is the run after it.
+template <typename T, typename Competitor, typename... Competitors>
+static void CheckStartup(cl::sycl::queue &queue, std::vector<T> const &vec,
+                         std::string_view description, Competitor &&competitor,
+                         Competitors &&... competitors) {
+  static_assert(sizeof...(competitors) % 2 == 0);
+  auto device = queue.get_device();
+  auto coldQueue = cl::sycl::queue{cl::sycl::context{device}, device};
+  auto Time = [&](cl::sycl::queue &q) {
+    auto result = vec;
+    return Utility::Benchmark([&]() { competitor(q, result); }).count() /
+           1000;
+  };
+  auto cold = Time(coldQueue);
+  auto prebuilt = Time(queue);
+  auto warm = Time(queue);
+  std::cout << description << " start-up time: cold " << cold
+            << ", prebuilt " << prebuilt << ", warm " << warm
+            << " microseconds" << std::endl;
   if constexpr (sizeof...(competitors) > 0)
-    _Check(result, vec, description, std::forward<Competitors>(competitors)...);
-
-  std::cout << std::endl;
+    CheckStartup(queue, vec, std::forward<Competitors>(competitors)...);
 }
 
 // Copy-paste https://stackoverflow.com/a/14880868/8099151
 // The 'i' is for int, there is a log2 for double in stdclib
-static unsigned int log2i(unsigned int x) {
+static unsigned int log2i(size_t x) {
 #if defined(__GNUC__) || defined(__clang__)
-  return 31 - __builtin_clz(x);
+  return 63 - __builtin_clzll(x);
 #else
   unsigned int log2Val = 0;
   // Count push off bits to right until 0
@@ -165,4 +667,28 @@ static unsigned int log2i(unsigned int x) {
 #endif
 }
 
-static unsigned int ClosestPowerOf2(unsigned int x) { return 1 << log2i(x); }
+static size_t ClosestPowerOf2(size_t x) { return size_t{1} << log2i(x); }
+
+static size_t NextPowerOf2(size_t x) {
+  auto lower = ClosestPowerOf2(x);
+  return lower == x ? x : lower << 1;
+}
+
+// Calls f with a value of the unsigned type of kernel indices into the array
+// of size elements padded to a power of two. 32-bit arithmetic is much faster
+// on GPUs, boxes of more than 2^31 elements need 64 bits.
+template <typename F> static auto WithIndexType(size_t size, F &&f) {
+  if (NextPowerOf2(size) <= (size_t{1} << 31))
+    return f(cl::sycl::cl_uint{});
+  return f(size_t{});
+}
+
+// Number of comparators in a bitonic step with boxes of boxSize elements
+// when only the first size elements of the padded array exist.
+// Comparators are enumerated so that their first element is increasing,
+// therefore all comparators with an index below this number are the only ones
+// that can touch the array.
+static size_t BitonicNComparators(size_t size, size_t boxSize) {
+  auto halfBoxSize = boxSize / 2;
+  return (size / boxSize) * halfBoxSize + std::min(size % boxSize, halfBoxSize);
+}